@@ -24,6 +24,21 @@ namespace AESCore {
     // For S-AES 256-bit key and 7 rounds, we need 8 round keys (1 initial + 7 rounds).
     // Total expansion size: 8 * 16 bytes = 128 bytes.
     std::vector<uint8_t> ExpandKey(const std::vector<uint8_t>& key, int rounds);
+
+    // Decryption key schedule for the equivalent inverse cipher: round keys in reverse
+    // order with InvMixColumns applied to the inner rounds.
+    std::vector<uint8_t> InvertKeySchedule(const std::vector<uint8_t>& expandedKey, int rounds);
+
+    // T-table round engine: SubBytes+ShiftRows+MixColumns fused into four 32-bit
+    // lookups and XORs per column. DecryptBlockT expects the InvertKeySchedule output.
+    void EncryptBlockT(const uint8_t* roundKeys, int rounds, const uint8_t* input, uint8_t* output);
+    void DecryptBlockT(const uint8_t* decKeys, int rounds, const uint8_t* input, uint8_t* output);
+
+    // Multi-buffer T-table engine: one block under each of four independent key schedules,
+    // processed in lockstep so the lookups of different messages overlap. input and
+    // output hold the four blocks back to back.
+    constexpr int MULTI_LANES = 4;
+    void EncryptBlocks4T(const uint8_t* const roundKeys[MULTI_LANES], int rounds, const uint8_t* input, uint8_t* output);
 }
 
 #endif
\ No newline at end of file
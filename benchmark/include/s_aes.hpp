@@ -10,22 +10,46 @@ public:
     // Initialize with a 128-bit key
     explicit SAES(const std::vector<uint8_t>& key);
 
-    // Encrypts using CBC mode, PKCS7 padding, 7 rounds, and 3-thread pool
+    // Encrypts using CBC mode, PKCS7 padding and 7 rounds. Each block chains on the
+    // previous ciphertext, so a single message is encrypted serially.
     std::vector<uint8_t> encrypt(const std::vector<uint8_t>& plaintext, const std::vector<uint8_t>& iv);
 
-    // Decrypts using CBC mode, PKCS7 padding, 7 rounds, and 3-thread pool
+    // Decrypts using CBC mode, PKCS7 padding and 7 rounds. Every block depends only on
+    // ciphertext, so block ranges are decrypted in parallel on the shared thread pool.
     std::vector<uint8_t> decrypt(const std::vector<uint8_t>& ciphertext, const std::vector<uint8_t>& iv);
 
+    // One message of a multi-buffer encryption: length / 16 blocks from input to output
+    // under cipher's key and a 16-byte iv
+    struct Job {
+        const SAES* cipher;
+        const uint8_t* iv;
+        const uint8_t* input;
+        uint8_t* output;
+        size_t length;
+    };
+
+    // CBC-encrypts independent messages (any mix of keys and IVs) together: each thread
+    // interleaves four messages through the block engine, and groups of messages are
+    // spread across the shared thread pool.
+    static void encryptMultiBuffer(const Job* jobs, size_t count);
+
 private:
     static constexpr int ROUNDS = 7; 
     std::vector<uint8_t> expandedKey;
+    std::vector<uint8_t> decryptionKey; // Equivalent inverse cipher schedule
 
     // Single block transformations mapped to Algorithm 1 and 2
     void encryptBlock(const uint8_t* input, uint8_t* output) const;
     void decryptBlock(const uint8_t* input, uint8_t* output) const;
 
-    // Thread pool orchestration for CBC processing
-    void processBlocksParallel(const std::vector<uint8_t>& input, std::vector<uint8_t>& output, const std::vector<uint8_t>& iv, bool isEncrypting);
+    // Serial CBC chain over numBlocks blocks
+    void encryptChain(const uint8_t* input, size_t numBlocks, const uint8_t* iv, uint8_t* output) const;
+
+    // Multi-buffer encryption of a group of jobs on the calling thread
+    static void encryptLanes(const Job* jobs, size_t count);
+
+    // Thread pool orchestration for CBC decryption
+    void processBlocksParallel(const std::vector<uint8_t>& input, std::vector<uint8_t>& output, const std::vector<uint8_t>& iv);
 };
 
-#endif
\ No newline at end of file
+#endif
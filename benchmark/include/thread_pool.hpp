@@ -0,0 +1,74 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing executor. Each worker owns a deque: it pushes and pops its own tasks
+// at the back while idle workers (and waiting callers) steal from the front of the
+// others. Callers of runTasks/parallelFor execute tasks themselves until their batch
+// completes, so a pool with zero workers degrades to running everything inline.
+class ThreadPool {
+public:
+    // Process-wide pool with one worker per core besides the caller, started on first use
+    static ThreadPool& shared();
+
+    explicit ThreadPool(unsigned int workers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int workerCount() const { return static_cast<unsigned int>(threads.size()); }
+
+    // Threads that execute a runTasks batch: the workers plus the calling thread
+    unsigned int concurrency() const { return workerCount() + 1; }
+
+    // Runs task(0) .. task(count - 1) and blocks until all have finished. The first
+    // exception thrown by a task is rethrown to the caller.
+    void runTasks(size_t count, const std::function<void(size_t)>& task);
+
+    // Splits [0, count) into contiguous ranges of at least grain items and runs
+    // body(begin, end) on each, in parallel. Small counts run inline on the caller.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    // Queues a task for components that share the pool. Runs inline if there are no workers.
+    template <typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto job = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+        std::future<Result> result = job->get_future();
+        push([job]() { (*job)(); });
+        return result;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queued{0};
+    std::atomic<unsigned int> nextQueue{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void push(std::function<void()> task);
+    // Pops from the caller's own deque, else steals from another; runs at most one task
+    bool runOne();
+    void workerLoop(unsigned int index);
+};
+
+#endif
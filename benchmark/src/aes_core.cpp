@@ -5,7 +5,7 @@
 namespace AESCore {
 
 // Constants
-static const uint8_t sbox[256] = {
+static constexpr uint8_t sbox[256] = {
     0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
     0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
     0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
@@ -24,7 +24,7 @@ static const uint8_t sbox[256] = {
     0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
 };
 
-static const uint8_t rsbox[256] = {
+static constexpr uint8_t rsbox[256] = {
     0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
     0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
     0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
@@ -47,19 +47,101 @@ static const uint8_t Rcon[11] = {
     0x8d, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
 };
 
-// Helper: Galois Field Multiplication
-inline uint8_t gf_mul(uint8_t a, uint8_t b) {
-    uint8_t p = 0;
-    for (int counter = 0; counter < 8; counter++) {
-        if ((b & 1) != 0) p ^= a;
-        bool hi_bit_set = (a & 0x80) != 0;
-        a <<= 1;
-        if (hi_bit_set) a ^= 0x1b;
-        b >>= 1;
+// T-tables: one state column of SubBytes+MixColumns (Te) or InvSubBytes+InvMixColumns (Td)
+// per input byte, packed big-endian so row 0 sits in the top byte of the word.
+// Te1..Te3 / Td1..Td3 are byte rotations of Te0 / Td0 for rows 1..3.
+// Te4 / Td4 replicate the plain (inverse) S-box for the final round, which skips MixColumns.
+struct TTables {
+    uint32_t Te0[256], Te1[256], Te2[256], Te3[256], Te4[256];
+    uint32_t Td0[256], Td1[256], Td2[256], Td3[256], Td4[256];
+};
+
+constexpr uint8_t xtime(uint8_t x) {
+    return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+constexpr uint32_t ror8(uint32_t w) {
+    return (w >> 8) | (w << 24);
+}
+
+constexpr TTables MakeTTables() {
+    TTables t{};
+    for (int i = 0; i < 256; ++i) {
+        uint8_t s = sbox[i];
+        uint8_t s2 = xtime(s);
+        uint8_t s3 = s2 ^ s;
+        uint32_t e = (uint32_t(s2) << 24) | (uint32_t(s) << 16) | (uint32_t(s) << 8) | s3;
+        t.Te0[i] = e;
+        t.Te1[i] = ror8(e);
+        t.Te2[i] = ror8(ror8(e));
+        t.Te3[i] = ror8(ror8(ror8(e)));
+        t.Te4[i] = uint32_t(s) * 0x01010101u;
+
+        uint8_t r = rsbox[i];
+        uint8_t r2 = xtime(r);
+        uint8_t r4 = xtime(r2);
+        uint8_t r8 = xtime(r4);
+        uint8_t r9 = r8 ^ r;
+        uint8_t rb = r8 ^ r2 ^ r;
+        uint8_t rd = r8 ^ r4 ^ r;
+        uint8_t re = r8 ^ r4 ^ r2;
+        uint32_t d = (uint32_t(re) << 24) | (uint32_t(r9) << 16) | (uint32_t(rd) << 8) | rb;
+        t.Td0[i] = d;
+        t.Td1[i] = ror8(d);
+        t.Td2[i] = ror8(ror8(d));
+        t.Td3[i] = ror8(ror8(ror8(d)));
+        t.Td4[i] = uint32_t(r) * 0x01010101u;
+    }
+    return t;
+}
+
+static constexpr TTables tables = MakeTTables();
+
+static inline uint32_t LoadWord(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static inline void StoreWord(uint8_t* p, uint32_t w) {
+    p[0] = static_cast<uint8_t>(w >> 24);
+    p[1] = static_cast<uint8_t>(w >> 16);
+    p[2] = static_cast<uint8_t>(w >> 8);
+    p[3] = static_cast<uint8_t>(w);
+}
+
+// GF(2^8) multiplication tables for the byte-wise MixColumns/InvMixColumns: one lookup
+// per coefficient instead of a shift-and-add loop.
+struct MulTables {
+    uint8_t mul2[256], mul3[256];
+    uint8_t mul9[256], mul11[256], mul13[256], mul14[256];
+};
+
+constexpr MulTables MakeMulTables() {
+    MulTables t{};
+    for (int i = 0; i < 256; ++i) {
+        uint8_t x = static_cast<uint8_t>(i);
+        uint8_t x2 = xtime(x);
+        uint8_t x4 = xtime(x2);
+        uint8_t x8 = xtime(x4);
+        t.mul2[i] = x2;
+        t.mul3[i] = x2 ^ x;
+        t.mul9[i] = x8 ^ x;
+        t.mul11[i] = x8 ^ x2 ^ x;
+        t.mul13[i] = x8 ^ x4 ^ x;
+        t.mul14[i] = x8 ^ x4 ^ x2;
     }
-    return p;
+    return t;
 }
 
+static constexpr MulTables mulTables = MakeMulTables();
+static constexpr const uint8_t (&mul2)[256] = mulTables.mul2;
+static constexpr const uint8_t (&mul3)[256] = mulTables.mul3;
+static constexpr const uint8_t (&mul9)[256] = mulTables.mul9;
+static constexpr const uint8_t (&mul11)[256] = mulTables.mul11;
+static constexpr const uint8_t (&mul13)[256] = mulTables.mul13;
+static constexpr const uint8_t (&mul14)[256] = mulTables.mul14;
+
+static_assert(mul2[0x80] == 0x1b && mul3[0xff] == 0x1a && mul14[0x01] == 0x0e, "GF(2^8) multiplication tables");
+
 void SubBytes(State& state) {
     for (int i = 0; i < 16; ++i) state[i] = sbox[state[i]];
 }
@@ -96,10 +178,10 @@ void MixColumns(State& state) {
     uint8_t tmp[16];
     for (int i = 0; i < 4; ++i) {
         int col = i * 4;
-        tmp[col]     = gf_mul(0x02, state[col]) ^ gf_mul(0x03, state[col+1]) ^ state[col+2] ^ state[col+3];
-        tmp[col+1]   = state[col] ^ gf_mul(0x02, state[col+1]) ^ gf_mul(0x03, state[col+2]) ^ state[col+3];
-        tmp[col+2]   = state[col] ^ state[col+1] ^ gf_mul(0x02, state[col+2]) ^ gf_mul(0x03, state[col+3]);
-        tmp[col+3]   = gf_mul(0x03, state[col]) ^ state[col+1] ^ state[col+2] ^ gf_mul(0x02, state[col+3]);
+        tmp[col]     = mul2[state[col]] ^ mul3[state[col+1]] ^ state[col+2] ^ state[col+3];
+        tmp[col+1]   = state[col] ^ mul2[state[col+1]] ^ mul3[state[col+2]] ^ state[col+3];
+        tmp[col+2]   = state[col] ^ state[col+1] ^ mul2[state[col+2]] ^ mul3[state[col+3]];
+        tmp[col+3]   = mul3[state[col]] ^ state[col+1] ^ state[col+2] ^ mul2[state[col+3]];
     }
     std::memcpy(state.data(), tmp, 16);
 }
@@ -108,10 +190,10 @@ void InvMixColumns(State& state) {
     uint8_t tmp[16];
     for (int i = 0; i < 4; ++i) {
         int col = i * 4;
-        tmp[col]   = gf_mul(0x0e, state[col]) ^ gf_mul(0x0b, state[col+1]) ^ gf_mul(0x0d, state[col+2]) ^ gf_mul(0x09, state[col+3]);
-        tmp[col+1] = gf_mul(0x09, state[col]) ^ gf_mul(0x0e, state[col+1]) ^ gf_mul(0x0b, state[col+2]) ^ gf_mul(0x0d, state[col+3]);
-        tmp[col+2] = gf_mul(0x0d, state[col]) ^ gf_mul(0x09, state[col+1]) ^ gf_mul(0x0e, state[col+2]) ^ gf_mul(0x0b, state[col+3]);
-        tmp[col+3] = gf_mul(0x0b, state[col]) ^ gf_mul(0x0d, state[col+1]) ^ gf_mul(0x09, state[col+2]) ^ gf_mul(0x0e, state[col+3]);
+        tmp[col]   = mul14[state[col]] ^ mul11[state[col+1]] ^ mul13[state[col+2]] ^ mul9[state[col+3]];
+        tmp[col+1] = mul9[state[col]] ^ mul14[state[col+1]] ^ mul11[state[col+2]] ^ mul13[state[col+3]];
+        tmp[col+2] = mul13[state[col]] ^ mul9[state[col+1]] ^ mul14[state[col+2]] ^ mul11[state[col+3]];
+        tmp[col+3] = mul11[state[col]] ^ mul13[state[col+1]] ^ mul9[state[col+2]] ^ mul14[state[col+3]];
     }
     std::memcpy(state.data(), tmp, 16);
 }
@@ -152,4 +234,95 @@ std::vector<uint8_t> ExpandKey(const std::vector<uint8_t>& key, int rounds) {
     return expandedKey;
 }
 
+std::vector<uint8_t> InvertKeySchedule(const std::vector<uint8_t>& expandedKey, int rounds) {
+    std::vector<uint8_t> decKey(expandedKey.size());
+
+    // Round keys are used in reverse order; the inner ones are passed through
+    // InvMixColumns so decryption can apply AddRoundKey after InvMixColumns.
+    for (int round = 0; round <= rounds; ++round) {
+        State roundKey;
+        std::memcpy(roundKey.data(), expandedKey.data() + ((rounds - round) * 16), 16);
+        if (round > 0 && round < rounds) InvMixColumns(roundKey);
+        std::memcpy(decKey.data() + (round * 16), roundKey.data(), 16);
+    }
+    return decKey;
+}
+
+void EncryptBlockT(const uint8_t* roundKeys, int rounds, const uint8_t* input, uint8_t* output) {
+    uint32_t s[4], t[4];
+    for (int c = 0; c < 4; ++c) s[c] = LoadWord(input + 4 * c) ^ LoadWord(roundKeys + 4 * c);
+
+    for (int round = 1; round < rounds; ++round) {
+        const uint8_t* rk = roundKeys + (round * 16);
+        for (int c = 0; c < 4; ++c) {
+            t[c] = tables.Te0[s[c] >> 24] ^ tables.Te1[(s[(c + 1) & 3] >> 16) & 0xff] ^
+                   tables.Te2[(s[(c + 2) & 3] >> 8) & 0xff] ^ tables.Te3[s[(c + 3) & 3] & 0xff] ^ LoadWord(rk + 4 * c);
+        }
+        for (int c = 0; c < 4; ++c) s[c] = t[c];
+    }
+
+    // Final round: SubBytes + ShiftRows + AddRoundKey
+    const uint8_t* rk = roundKeys + (rounds * 16);
+    for (int c = 0; c < 4; ++c) {
+        t[c] = (tables.Te4[s[c] >> 24] & 0xff000000) ^ (tables.Te4[(s[(c + 1) & 3] >> 16) & 0xff] & 0x00ff0000) ^
+               (tables.Te4[(s[(c + 2) & 3] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Te4[s[(c + 3) & 3] & 0xff] & 0x000000ff) ^
+               LoadWord(rk + 4 * c);
+        StoreWord(output + 4 * c, t[c]);
+    }
+}
+
+void EncryptBlocks4T(const uint8_t* const roundKeys[MULTI_LANES], int rounds, const uint8_t* input, uint8_t* output) {
+    uint32_t s[MULTI_LANES][4], t[MULTI_LANES][4];
+    for (int l = 0; l < MULTI_LANES; ++l) {
+        for (int c = 0; c < 4; ++c) s[l][c] = LoadWord(input + 16 * l + 4 * c) ^ LoadWord(roundKeys[l] + 4 * c);
+    }
+
+    for (int round = 1; round < rounds; ++round) {
+        for (int l = 0; l < MULTI_LANES; ++l) {
+            const uint8_t* rk = roundKeys[l] + (round * 16);
+            for (int c = 0; c < 4; ++c) {
+                t[l][c] = tables.Te0[s[l][c] >> 24] ^ tables.Te1[(s[l][(c + 1) & 3] >> 16) & 0xff] ^
+                          tables.Te2[(s[l][(c + 2) & 3] >> 8) & 0xff] ^ tables.Te3[s[l][(c + 3) & 3] & 0xff] ^ LoadWord(rk + 4 * c);
+            }
+        }
+        for (int l = 0; l < MULTI_LANES; ++l) {
+            for (int c = 0; c < 4; ++c) s[l][c] = t[l][c];
+        }
+    }
+
+    // Final round: SubBytes + ShiftRows + AddRoundKey
+    for (int l = 0; l < MULTI_LANES; ++l) {
+        const uint8_t* rk = roundKeys[l] + (rounds * 16);
+        for (int c = 0; c < 4; ++c) {
+            t[l][c] = (tables.Te4[s[l][c] >> 24] & 0xff000000) ^ (tables.Te4[(s[l][(c + 1) & 3] >> 16) & 0xff] & 0x00ff0000) ^
+                      (tables.Te4[(s[l][(c + 2) & 3] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Te4[s[l][(c + 3) & 3] & 0xff] & 0x000000ff) ^
+                      LoadWord(rk + 4 * c);
+            StoreWord(output + 16 * l + 4 * c, t[l][c]);
+        }
+    }
+}
+
+void DecryptBlockT(const uint8_t* decKeys, int rounds, const uint8_t* input, uint8_t* output) {
+    uint32_t s[4], t[4];
+    for (int c = 0; c < 4; ++c) s[c] = LoadWord(input + 4 * c) ^ LoadWord(decKeys + 4 * c);
+
+    for (int round = 1; round < rounds; ++round) {
+        const uint8_t* rk = decKeys + (round * 16);
+        for (int c = 0; c < 4; ++c) {
+            t[c] = tables.Td0[s[c] >> 24] ^ tables.Td1[(s[(c + 3) & 3] >> 16) & 0xff] ^
+                   tables.Td2[(s[(c + 2) & 3] >> 8) & 0xff] ^ tables.Td3[s[(c + 1) & 3] & 0xff] ^ LoadWord(rk + 4 * c);
+        }
+        for (int c = 0; c < 4; ++c) s[c] = t[c];
+    }
+
+    // Final round: InvShiftRows + InvSubBytes + AddRoundKey
+    const uint8_t* rk = decKeys + (rounds * 16);
+    for (int c = 0; c < 4; ++c) {
+        t[c] = (tables.Td4[s[c] >> 24] & 0xff000000) ^ (tables.Td4[(s[(c + 3) & 3] >> 16) & 0xff] & 0x00ff0000) ^
+               (tables.Td4[(s[(c + 2) & 3] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Td4[s[(c + 1) & 3] & 0xff] & 0x000000ff) ^
+               LoadWord(rk + 4 * c);
+        StoreWord(output + 4 * c, t[c]);
+    }
+}
+
 } // namespace AESCore
\ No newline at end of file
@@ -1,105 +1,134 @@
 #include "s_aes.hpp"
 #include "aes_core.hpp"
-#include <thread>
+#include "thread_pool.hpp"
 #include <cmath>
 #include <cstring>
 
+// Blocks per decryption task: enough work to amortize handing a range to the pool
+static constexpr size_t CBC_DECRYPT_GRAIN = 256;
+
 SAES::SAES(const std::vector<uint8_t>& key) {
     expandedKey = AESCore::ExpandKey(key, ROUNDS);
+    decryptionKey = AESCore::InvertKeySchedule(expandedKey, ROUNDS);
 }
 
 void SAES::encryptBlock(const uint8_t* input, uint8_t* output) const {
-    AESCore::State state;
-    std::memcpy(state.data(), input, 16);
-    
-    AESCore::AddRoundKey(state, expandedKey.data());
-
-    for (int round = 1; round < ROUNDS; ++round) {
-        AESCore::SubBytes(state);
-        AESCore::ShiftRows(state);
-        AESCore::MixColumns(state);
-        AESCore::AddRoundKey(state, expandedKey.data() + (round * 16));
-    }
-
-    AESCore::SubBytes(state);
-    AESCore::ShiftRows(state);
-    AESCore::AddRoundKey(state, expandedKey.data() + (ROUNDS * 16));
-    
-    std::memcpy(output, state.data(), 16);
+    AESCore::EncryptBlockT(expandedKey.data(), ROUNDS, input, output);
 }
 
 void SAES::decryptBlock(const uint8_t* input, uint8_t* output) const {
-    AESCore::State state;
-    std::memcpy(state.data(), input, 16);
-
-    AESCore::AddRoundKey(state, expandedKey.data() + (ROUNDS * 16));
-
-    for (int round = ROUNDS - 1; round > 0; --round) {
-        AESCore::InvShiftRows(state);
-        AESCore::InvSubBytes(state);
-        AESCore::AddRoundKey(state, expandedKey.data() + (round * 16));
-        AESCore::InvMixColumns(state);
-    }
-
-    AESCore::InvShiftRows(state);
-    AESCore::InvSubBytes(state);
-    AESCore::AddRoundKey(state, expandedKey.data());
-
-    std::memcpy(output, state.data(), 16);
+    AESCore::DecryptBlockT(decryptionKey.data(), ROUNDS, input, output);
 }
 
 std::vector<uint8_t> SAES::encrypt(const std::vector<uint8_t>& plaintext, const std::vector<uint8_t>& iv) {
     std::vector<uint8_t> output(plaintext.size());
-    processBlocksParallel(plaintext, output, iv, true);
+    encryptChain(plaintext.data(), plaintext.size() / 16, iv.data(), output.data());
     return output;
 }
 
 std::vector<uint8_t> SAES::decrypt(const std::vector<uint8_t>& ciphertext, const std::vector<uint8_t>& iv) {
     std::vector<uint8_t> output(ciphertext.size());
-    processBlocksParallel(ciphertext, output, iv, false);
+    processBlocksParallel(ciphertext, output, iv);
     return output;
 }
 
-void SAES::processBlocksParallel(const std::vector<uint8_t>& input, std::vector<uint8_t>& output, const std::vector<uint8_t>& iv, bool isEncrypting) {
-    size_t numBlocks = input.size() / 16;
+void SAES::encryptChain(const uint8_t* input, size_t numBlocks, const uint8_t* iv, uint8_t* output) const {
+    const uint8_t* chain = iv;
+    for (size_t i = 0; i < numBlocks; ++i) {
+        uint8_t block[16];
+        for (int j = 0; j < 16; ++j) block[j] = input[i * 16 + j] ^ chain[j];
+        encryptBlock(block, output + (i * 16));
+        chain = output + (i * 16);
+    }
+}
 
-    auto processChunk = [&](size_t startBlock, size_t endBlock, std::vector<uint8_t> currentIv) {
-        for (size_t i = startBlock; i < endBlock; ++i) {
-            const uint8_t* inPtr = input.data() + (i * 16);
-            uint8_t* outPtr = output.data() + (i * 16);
-            
-            if (isEncrypting) {
-                uint8_t block[16];
-                for (int j = 0; j < 16; ++j) block[j] = inPtr[j] ^ currentIv[j];
-                encryptBlock(block, outPtr);
-                std::memcpy(currentIv.data(), outPtr, 16);
-            } else {
-                decryptBlock(inPtr, outPtr);
-                for (int j = 0; j < 16; ++j) outPtr[j] ^= currentIv[j];
-                std::memcpy(currentIv.data(), inPtr, 16);
-            }
+void SAES::encryptLanes(const Job* jobs, size_t count) {
+    struct Lane {
+        const Job* job = nullptr;
+        size_t block = 0;
+        size_t blocks = 0;
+        uint8_t chain[16];
+    };
+
+    Lane lanes[AESCore::MULTI_LANES];
+    size_t next = 0;
+
+    // Moves the next non-empty job into a lane; returns false when none are left
+    auto load = [&](Lane& lane) {
+        while (next < count && jobs[next].length < 16) ++next;
+        if (next == count) {
+            lane.job = nullptr;
+            return false;
         }
+        lane.job = &jobs[next++];
+        lane.block = 0;
+        lane.blocks = lane.job->length / 16;
+        std::memcpy(lane.chain, lane.job->iv, 16);
+        return true;
     };
 
-    if (numBlocks < 3) {
-        processChunk(0, numBlocks, iv);
-    } else {
-        size_t blocksPerThread = numBlocks / 3;
-        size_t remainder = numBlocks % 3;
+    int active = 0;
+    for (Lane& lane : lanes) {
+        if (load(lane)) ++active;
+    }
 
-        size_t end1 = blocksPerThread + (remainder > 0 ? 1 : 0);
-        size_t end2 = end1 + blocksPerThread + (remainder > 1 ? 1 : 0);
+    uint8_t in[16 * AESCore::MULTI_LANES] = {};
+    uint8_t out[16 * AESCore::MULTI_LANES];
+    const uint8_t* keys[AESCore::MULTI_LANES];
 
-        std::vector<uint8_t> iv1 = iv;
-        std::vector<uint8_t> iv2 = iv; 
-        std::vector<uint8_t> iv3 = iv; 
+    while (active > 1) {
+        const uint8_t* anyKey = nullptr;
+        for (const Lane& lane : lanes) {
+            if (lane.job) anyKey = lane.job->cipher->expandedKey.data();
+        }
+
+        // Idle lanes encrypt a dummy block so the engine always runs four wide
+        for (int l = 0; l < AESCore::MULTI_LANES; ++l) {
+            const Lane& lane = lanes[l];
+            keys[l] = anyKey;
+            if (!lane.job) continue;
+            keys[l] = lane.job->cipher->expandedKey.data();
+            const uint8_t* src = lane.job->input + (lane.block * 16);
+            for (int j = 0; j < 16; ++j) in[l * 16 + j] = src[j] ^ lane.chain[j];
+        }
 
-        std::thread t1(processChunk, 0, end1, iv1);
-        std::thread t2(processChunk, end1, end2, iv2);
-        std::thread t3(processChunk, end2, numBlocks, iv3);
+        AESCore::EncryptBlocks4T(keys, ROUNDS, in, out);
 
-        t1.join();
-        t2.join();
-        t3.join();
+        for (int l = 0; l < AESCore::MULTI_LANES; ++l) {
+            Lane& lane = lanes[l];
+            if (!lane.job) continue;
+            std::memcpy(lane.job->output + (lane.block * 16), out + (l * 16), 16);
+            std::memcpy(lane.chain, out + (l * 16), 16);
+            if (++lane.block == lane.blocks && !load(lane)) --active;
+        }
     }
-}
\ No newline at end of file
+
+    // The last message has nothing to interleave with: finish it on the single-block path
+    for (Lane& lane : lanes) {
+        if (!lane.job) continue;
+        size_t done = lane.block * 16;
+        lane.job->cipher->encryptChain(lane.job->input + done, lane.blocks - lane.block, lane.chain, lane.job->output + done);
+    }
+}
+
+void SAES::encryptMultiBuffer(const Job* jobs, size_t count) {
+    ThreadPool::shared().parallelFor(count, AESCore::MULTI_LANES, [&](size_t begin, size_t end) {
+        encryptLanes(jobs + begin, end - begin);
+    });
+}
+
+void SAES::processBlocksParallel(const std::vector<uint8_t>& input, std::vector<uint8_t>& output, const std::vector<uint8_t>& iv) {
+    size_t numBlocks = input.size() / 16;
+
+    // P_i = D(C_i) ^ C_{i-1}: ranges are independent, each reading the ciphertext
+    // block before its start as the chaining value
+    ThreadPool::shared().parallelFor(numBlocks, CBC_DECRYPT_GRAIN, [&](size_t startBlock, size_t endBlock) {
+        for (size_t i = startBlock; i < endBlock; ++i) {
+            const uint8_t* inPtr = input.data() + (i * 16);
+            const uint8_t* chain = i == 0 ? iv.data() : inPtr - 16;
+            uint8_t* outPtr = output.data() + (i * 16);
+            decryptBlock(inPtr, outPtr);
+            for (int j = 0; j < 16; ++j) outPtr[j] ^= chain[j];
+        }
+    });
+}
@@ -0,0 +1,170 @@
+#include "thread_pool.hpp"
+#include <exception>
+
+// Identifies pool workers so push/runOne use the worker's own deque
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local unsigned int currentIndex = 0;
+
+static unsigned int DefaultWorkers() {
+    unsigned int cores = std::thread::hardware_concurrency();
+    if (cores == 0) return 3;
+    return cores - 1;
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(DefaultWorkers());
+    return pool;
+}
+
+ThreadPool::ThreadPool(unsigned int workers) {
+    for (unsigned int i = 0; i < workers; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned int i = 0; i < workers; ++i) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::push(std::function<void()> task) {
+    if (threads.empty()) {
+        task();
+        return;
+    }
+
+    unsigned int index = currentPool == this ? currentIndex : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::runOne() {
+    size_t n = queues.size();
+    if (n == 0) return false;
+
+    std::function<void()> task;
+    size_t self = currentPool == this ? currentIndex : n;
+    if (self < n) {
+        std::lock_guard<std::mutex> lock(queues[self]->mutex);
+        if (!queues[self]->tasks.empty()) {
+            task = std::move(queues[self]->tasks.back());
+            queues[self]->tasks.pop_back();
+        }
+    }
+
+    if (!task) {
+        size_t start = self < n ? self + 1 : nextQueue.load(std::memory_order_relaxed);
+        for (size_t k = 0; k < n && !task; ++k) {
+            size_t victim = (start + k) % n;
+            if (victim == self) continue;
+            std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+            if (!queues[victim]->tasks.empty()) {
+                task = std::move(queues[victim]->tasks.front());
+                queues[victim]->tasks.pop_front();
+            }
+        }
+    }
+
+    if (!task) return false;
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(unsigned int index) {
+    currentPool = this;
+    currentIndex = index;
+
+    while (true) {
+        if (runOne()) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping && queued.load(std::memory_order_acquire) == 0) return;
+    }
+}
+
+void ThreadPool::runTasks(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) return;
+    if (count == 1 || threads.empty()) {
+        for (size_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    // Shared with the queued tasks, which may still hold it briefly after the last
+    // one has signalled completion
+    struct Batch {
+        std::atomic<size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->remaining.store(count, std::memory_order_relaxed);
+
+    auto run = [batch, &task](size_t i) {
+        try {
+            task(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            if (!batch->error) batch->error = std::current_exception();
+        }
+        if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            batch->done.notify_all();
+        }
+    };
+
+    // Queue the tail and run the head here; the caller keeps executing queued tasks
+    // (its own or anyone's) rather than sleeping while work is available
+    for (size_t i = 1; i < count; ++i) {
+        push([run, i]() { run(i); });
+    }
+    run(0);
+
+    while (batch->remaining.load(std::memory_order_acquire) != 0) {
+        if (runOne()) continue;
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->done.wait(lock, [&]() { return batch->remaining.load(std::memory_order_acquire) == 0; });
+    }
+
+    if (batch->error) std::rethrow_exception(batch->error);
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    // A few ranges per thread so stealing can even out uneven progress
+    size_t tasks = (count + grain - 1) / grain;
+    size_t maxTasks = size_t(4) * concurrency();
+    if (tasks > maxTasks) tasks = maxTasks;
+    if (tasks <= 1) {
+        body(0, count);
+        return;
+    }
+
+    size_t base = count / tasks;
+    size_t remainder = count % tasks;
+    runTasks(tasks, [&](size_t i) {
+        size_t begin = i * base + (i < remainder ? i : remainder);
+        size_t end = begin + base + (i < remainder ? 1 : 0);
+        body(begin, end);
+    });
+}
@@ -1,11 +1,13 @@
 #include "../include/s_aes.hpp"
 #include "../include/m_rsa.hpp"
+#include "../include/key_store.hpp"
 #include "../include/utils.hpp"
 #include "../include/net_protocol.hpp"
 #include <winsock2.h>
 #include <iostream>
 #include <vector>
 #include <cstring>
+#include <utility>
 
 #pragma comment(lib, "ws2_32.lib")
 
@@ -16,14 +18,14 @@ struct TransmissionPayload {
 };
 
 class ReceiverNode {
-    TriplePrimeKey privateKey;
+    MRSA::PrivateKeyContext privateKey;  // CRT material derived once, reused for every session key
 public:
-    ReceiverNode(const TriplePrimeKey& key) : privateKey(key) {}
+    ReceiverNode(const MultiPrimeKey& key) : privateKey(key) {}
 
     std::vector<uint8_t> processReceivedData(const std::vector<uint8_t>& encKey, 
-                                             const std::vector<uint8_t>& encData, 
+                                             std::vector<uint8_t> encData, 
                                              const std::vector<uint8_t>& iv) {
-        std::vector<uint8_t> K = MRSA::decrypt(encKey, privateKey);
+        std::vector<uint8_t> K = MRSA::decrypt(encKey, privateKey, MRSA::CrtMode::Parallel);
         // OpenSSL may leave leading zeros if output is exactly 16 bytes but sometimes less/more due to padding.
         // Assuming K is exactly 16 bytes for AES-128 if done raw:
         std::vector<uint8_t> paddedK(16, 0);
@@ -33,15 +35,16 @@ public:
             std::memcpy(paddedK.data(), K.data() + K.size() - 16, 16);
         }
         
-        SAES aes(paddedK);
-        std::vector<uint8_t> paddedData = aes.decrypt(encData, iv);
-        Utils::removePKCS7Padding(paddedData);
-        return paddedData;
+        SAES<> aes(paddedK);
+        aes.decrypt(encData.data(), encData.size(), iv.data(), encData.data());
+        Utils::removePKCS7Padding(encData);
+        return encData;
     }
 };
 
 int main() {
-    TriplePrimeKey tpk = MRSA::generateKey(1024);
+    // Reuse the key saved by an earlier run; only the first run pays for prime generation
+    MultiPrimeKey tpk = KeyStore::loadOrGenerate("receiver.key", 1024);
     ReceiverNode server(tpk);
 
     WSADATA wsaData;
@@ -57,6 +60,12 @@ int main() {
     listen(serverSocket, 1);
     
     std::cout << "Receiver: Listening on port 8080..." << std::endl;
+    // Tell the runner it can start the sender now rather than after a fixed delay
+    HANDLE readyEvent = OpenEventA(EVENT_MODIFY_STATE, FALSE, "MRA_ReceiverReady");
+    if (readyEvent) {
+        SetEvent(readyEvent);
+        CloseHandle(readyEvent);
+    }
     struct sockaddr_in clientAddr;
     int clientAddrLen = sizeof(clientAddr);
     SOCKET clientSocket = accept(serverSocket, (struct sockaddr*)&clientAddr, &clientAddrLen);
@@ -96,7 +105,7 @@ int main() {
 
         // Decrypt
         try {
-            std::vector<uint8_t> plaintext = server.processReceivedData(encKey, encData, iv);
+            std::vector<uint8_t> plaintext = server.processReceivedData(encKey, std::move(encData), iv);
             std::cout << "Receiver: Decrypted message - " << std::string(plaintext.begin(), plaintext.end()) << std::endl;
         } catch (const std::exception& e) {
             std::cerr << "Receiver: Decryption failure: " << e.what() << std::endl;
@@ -18,11 +18,10 @@ struct TransmissionPayload {
 };
 
 class SenderNode {
-    std::vector<uint8_t> public_n;
-    std::vector<uint8_t> public_e;
+    MRSA::PublicKeyContext publicKey;  // modulus and Montgomery context parsed once, reused for every session key
 public:
     SenderNode(const std::vector<uint8_t>& n, const std::vector<uint8_t>& e)
-        : public_n(n), public_e(e) {}
+        : publicKey(n, e) {}
 
     TransmissionPayload transmitData(const std::vector<uint8_t>& data) {
         TransmissionPayload payload;
@@ -31,12 +30,12 @@ public:
         RAND_bytes(K.data(), 16);
         RAND_bytes(iv.data(), 16);
         
-        payload.encryptedAesKey = MRSA::encrypt(K, public_n, public_e);
+        payload.encryptedAesKey = MRSA::encrypt(K, publicKey);
         
-        SAES aes(K);
-        std::vector<uint8_t> paddedData = data;
-        Utils::addPKCS7Padding(paddedData, 16);
-        payload.encryptedData = aes.encrypt(paddedData, iv);
+        SAES<> aes(K);
+        payload.encryptedData = data;
+        Utils::addPKCS7Padding(payload.encryptedData, 16);
+        aes.encrypt(payload.encryptedData.data(), payload.encryptedData.size(), iv.data(), payload.encryptedData.data());
         payload.iv = iv;
         
         return payload;
@@ -2,13 +2,30 @@
 #define AES_CORE_HPP
 
 #include <cstdint>
+#include <cstddef>
 #include <array>
 #include <vector>
+#include <type_traits>
 
 namespace AESCore {
     // Standard AES State: 4x4 matrix of bytes in column-major order
     using State = std::array<uint8_t, 16>;
 
+    // Supported round counts: 7 (S-AES), 10/12/14 (AES-128/192/256).
+    // Every template below is explicitly instantiated for exactly these.
+    constexpr size_t KeySizeFor(int rounds) {
+        return rounds == 12 ? 24 : (rounds == 14 ? 32 : 16);
+    }
+
+    // Compile-time loop: calls f(std::integral_constant<int, I>()) for I in [Begin, End)
+    template <int Begin, int End, typename F>
+    inline void Unroll(F&& f) {
+        if constexpr (Begin < End) {
+            f(std::integral_constant<int, Begin>());
+            Unroll<Begin + 1, End>(f);
+        }
+    }
+
     // Core forward transformations
     void SubBytes(State& state);
     void ShiftRows(State& state);
@@ -21,9 +38,71 @@ namespace AESCore {
     void InvMixColumns(State& state);
 
     // Key Expansion
-    // For S-AES 256-bit key and 7 rounds, we need 8 round keys (1 initial + 7 rounds).
+    // For S-AES 128-bit key and 7 rounds, we need 8 round keys (1 initial + 7 rounds).
     // Total expansion size: 8 * 16 bytes = 128 bytes.
+    // Standard AES uses 16/24/32-byte keys for 10/12/14 rounds.
+    // Writes 16 * (rounds + 1) bytes to expandedKey; throws on a key length/round mismatch.
+    void ExpandKey(const uint8_t* key, size_t keyLength, int rounds, uint8_t* expandedKey);
     std::vector<uint8_t> ExpandKey(const std::vector<uint8_t>& key, int rounds);
+
+    // Decryption key schedule for the equivalent inverse cipher: round keys in reverse
+    // order with InvMixColumns applied to the inner rounds.
+    void InvertKeySchedule(const uint8_t* expandedKey, int rounds, uint8_t* decKey);
+    std::vector<uint8_t> InvertKeySchedule(const std::vector<uint8_t>& expandedKey, int rounds);
+
+    // T-table round engine: SubBytes+ShiftRows+MixColumns fused into four 32-bit
+    // lookups and XORs per column. DecryptBlockT expects the InvertKeySchedule output.
+    template <int Rounds> void EncryptBlockT(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output);
+    template <int Rounds> void EncryptBlocksT(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks);
+    template <int Rounds> void DecryptBlockT(const uint8_t* decKeys, const uint8_t* input, uint8_t* output);
+
+    // Byte-wise reference engine built from the round functions above
+    template <int Rounds> void EncryptBlockRef(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output);
+    template <int Rounds> void EncryptBlocksRef(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks);
+    template <int Rounds> void DecryptBlockRef(const uint8_t* decKeys, const uint8_t* input, uint8_t* output);
+
+    // AES-NI engine (AESENC/AESENCLAST, AESDEC/AESDECLAST). Only valid on CPUs with AES-NI.
+    template <int Rounds> void EncryptBlockNI(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output);
+    template <int Rounds> void EncryptBlocksNI(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks);
+    template <int Rounds> void DecryptBlockNI(const uint8_t* decKeys, const uint8_t* input, uint8_t* output);
+    // Block i is encrypted under roundKeys[i], so blocks of unrelated messages share the pipeline
+    template <int Rounds> void EncryptBlocksMultiKeyNI(const uint8_t* const* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks);
+
+    // Vector-permute engine (SSSE3 PSHUFB): tower-field S-box evaluated from in-register
+    // nibble tables, so no memory access depends on key or data. Needs SSSE3.
+    template <int Rounds> void EncryptBlockVP(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output);
+    template <int Rounds> void EncryptBlocksVP(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks);
+    template <int Rounds> void DecryptBlockVP(const uint8_t* decKeys, const uint8_t* input, uint8_t* output);
+
+    // Bitsliced engine: four blocks as eight 64-bit bit planes, S-box as a boolean circuit.
+    // Portable integer code with no table lookups, for cores without AES instructions or SIMD.
+    template <int Rounds> void EncryptBlockBS(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output);
+    template <int Rounds> void EncryptBlocksBS(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks);
+    template <int Rounds> void DecryptBlockBS(const uint8_t* decKeys, const uint8_t* input, uint8_t* output);
+
+    // Backend selection
+    // Auto picks the fastest engine the CPU supports: AES-NI, then vector-permute, then
+    // T-table. The initial choice can be forced with the SAES_BACKEND environment variable
+    // ("auto", "reference", "ttable", "aesni", "vperm", "bitslice").
+    enum class Backend { Auto, Reference, TTable, AESNI, VPerm, Bitslice };
+
+    template <int Rounds>
+    struct BlockKernel {
+        Backend backend;
+        void (*encryptBlock)(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output);
+        void (*decryptBlock)(const uint8_t* decKeys, const uint8_t* input, uint8_t* output);
+        // Encrypts numBlocks independent blocks, interleaving them to hide round latency
+        void (*encryptBlocks)(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks);
+        // As encryptBlocks, but block i uses the schedule at roundKeys[i]
+        void (*encryptBlocksMultiKey)(const uint8_t* const* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks);
+    };
+
+    // Forces a backend for SAES instances created afterwards. Throws if the CPU lacks support.
+    void SetBackend(Backend backend);
+    Backend ActiveBackend();
+    bool IsBackendSupported(Backend backend);
+    const char* BackendName(Backend backend);
+    template <int Rounds> const BlockKernel<Rounds>& ActiveKernel();
 }
 
-#endif
\ No newline at end of file
+#endif
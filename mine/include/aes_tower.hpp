@@ -0,0 +1,109 @@
+#ifndef AES_TOWER_HPP
+#define AES_TOWER_HPP
+
+#include <cstdint>
+
+// Compile-time arithmetic for the table-free backends (vector-permute and bitsliced).
+// GF(2^8) is rewritten as the tower GF(16)[Y]/(Y^2 + Y + lambda) with GF(16) taken
+// modulo x^4 + x + 1, where inversion reduces to a few GF(16) operations. A tower
+// element alpha*Y + beta is stored as the byte (alpha << 4) | beta.
+namespace AESCore {
+namespace Tower {
+    // GF(2^8) modulo the AES polynomial
+    constexpr uint8_t Mul8(uint8_t a, uint8_t b) {
+        uint8_t p = 0;
+        for (int i = 0; i < 8; ++i) {
+            if (b & 1) p ^= a;
+            a = static_cast<uint8_t>((a << 1) ^ ((a & 0x80) ? 0x1b : 0x00));
+            b >>= 1;
+        }
+        return p;
+    }
+
+    // GF(16) modulo x^4 + x + 1
+    constexpr uint8_t Mul4(uint8_t a, uint8_t b) {
+        uint8_t p = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (b & 1) p ^= a;
+            a = static_cast<uint8_t>(((a << 1) ^ ((a & 0x08) ? 0x03 : 0x00)) & 0x0f);
+            b >>= 1;
+        }
+        return p;
+    }
+
+    constexpr uint8_t Inv4(uint8_t a) {
+        for (int b = 1; b < 16; ++b) {
+            if (Mul4(a, static_cast<uint8_t>(b)) == 1) return static_cast<uint8_t>(b);
+        }
+        return 0;
+    }
+
+    constexpr uint8_t Rotl8(uint8_t x, int n) {
+        return static_cast<uint8_t>((x << n) | (x >> (8 - n)));
+    }
+
+    // Linear parts of the AES affine map and its inverse (the constant is 0x63)
+    constexpr uint8_t Affine(uint8_t x) {
+        return static_cast<uint8_t>(x ^ Rotl8(x, 1) ^ Rotl8(x, 2) ^ Rotl8(x, 3) ^ Rotl8(x, 4));
+    }
+
+    constexpr uint8_t InvAffine(uint8_t x) {
+        return static_cast<uint8_t>(Rotl8(x, 1) ^ Rotl8(x, 3) ^ Rotl8(x, 6));
+    }
+
+    // Reference S-box entry: inverse in GF(2^8) followed by the affine map
+    constexpr uint8_t SBox(uint8_t x) {
+        uint8_t inverse = 0;
+        for (int y = 1; y < 256 && x != 0 && inverse == 0; ++y) {
+            if (Mul8(x, static_cast<uint8_t>(y)) == 1) inverse = static_cast<uint8_t>(y);
+        }
+        return static_cast<uint8_t>(Affine(inverse) ^ 0x63);
+    }
+
+    struct Basis {
+        uint8_t lambda;
+        uint8_t toPoly[256];   // tower -> polynomial basis
+        uint8_t toTower[256];  // polynomial -> tower basis
+    };
+
+    constexpr Basis MakeBasis() {
+        Basis basis{};
+
+        // lambda: Y^2 + Y + lambda has no root in GF(16)
+        for (int l = 1; l < 16 && basis.lambda == 0; ++l) {
+            bool hasRoot = false;
+            for (int y = 0; y < 16; ++y) {
+                if ((Mul4(static_cast<uint8_t>(y), static_cast<uint8_t>(y)) ^ y ^ l) == 0) hasRoot = true;
+            }
+            if (!hasRoot) basis.lambda = static_cast<uint8_t>(l);
+        }
+
+        // Embedding: gamma is a root of x^4 + x + 1 in GF(2^8), beta a root of Y^2 + Y + lambda
+        uint8_t gamma = 0;
+        for (int g = 2; g < 256 && gamma == 0; ++g) {
+            uint8_t g2 = Mul8(static_cast<uint8_t>(g), static_cast<uint8_t>(g));
+            if ((Mul8(g2, g2) ^ g ^ 1) == 0) gamma = static_cast<uint8_t>(g);
+        }
+        uint8_t powers[4] = {1, gamma, Mul8(gamma, gamma), Mul8(Mul8(gamma, gamma), gamma)};
+        uint8_t embedded[16] = {};
+        for (int n = 0; n < 16; ++n) {
+            for (int i = 0; i < 4; ++i) {
+                if (n & (1 << i)) embedded[n] ^= powers[i];
+            }
+        }
+        uint8_t beta = 0;
+        for (int b = 2; b < 256 && beta == 0; ++b) {
+            if ((Mul8(static_cast<uint8_t>(b), static_cast<uint8_t>(b)) ^ b ^ embedded[basis.lambda]) == 0) beta = static_cast<uint8_t>(b);
+        }
+
+        for (int x = 0; x < 256; ++x) {
+            uint8_t p = static_cast<uint8_t>(Mul8(embedded[x >> 4], beta) ^ embedded[x & 0x0f]);
+            basis.toPoly[x] = p;
+            basis.toTower[p] = static_cast<uint8_t>(x);
+        }
+        return basis;
+    }
+}
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef AUTOTUNE_HPP
+#define AUTOTUNE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "aes_core.hpp"
+
+class ThreadPool;
+
+// Parallelism thresholds for CTR processing, derived from two measurements taken on
+// first use of a backend/round count with a pool of a given worker count: the per-block
+// keystream cost and the cost of one parallel dispatch on that pool. If SAES_TUNING_PROFILE names a file, it
+// is read before measuring and rewritten with every new measurement; a profile that
+// cannot be parsed or written is ignored, never an error.
+namespace Autotune {
+    struct Params {
+        double blockNanos = 0;        // keystream + XOR cost per 16-byte block
+        double dispatchNanos = 0;     // fan-out and join of one batch of pool tasks
+        size_t minBlocksPerTask = 0;  // a task must amortize the dispatch cost this many times over
+        size_t serialCutoff = 0;      // messages with fewer blocks run inline on the caller
+    };
+
+    struct Entry {
+        AESCore::Backend backend;
+        int rounds;
+        unsigned int workers;         // worker count of the pool the dispatch was measured on
+        Params params;
+    };
+
+    // Tuned parameters for the kernel's backend at this round count, running on pool.
+    // Pools with the same worker count share one measurement.
+    template <int Rounds> const Params& ForKernel(const AESCore::BlockKernel<Rounds>& kernel, ThreadPool& pool);
+
+    // Number of tasks worth splitting numBlocks into, at most concurrency; 1 means run inline
+    size_t TaskCount(const Params& params, size_t numBlocks, unsigned int concurrency);
+
+    // Every parameter set measured or loaded so far
+    std::vector<Entry> Snapshot();
+
+    // Profile lines are "<backend> <rounds> <blockNanos> <dispatchNanos> <workers>".
+    // LoadProfile keeps entries that already exist, returns false if the file cannot be
+    // opened and throws on malformed lines, leaving the registry unchanged.
+    bool LoadProfile(const std::string& path);
+    void SaveProfile(const std::string& path);
+}
+
+#endif
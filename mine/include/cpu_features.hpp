@@ -0,0 +1,17 @@
+#ifndef CPU_FEATURES_HPP
+#define CPU_FEATURES_HPP
+
+namespace CpuFeatures {
+    // Instruction set extensions relevant to the cipher backends
+    struct Flags {
+        bool aesni = false;
+        bool ssse3 = false;
+        bool pclmul = false;
+        bool avx2 = false;  // only set when the OS also saves the YMM registers
+    };
+
+    // Queried once via CPUID and cached. All flags are false on non-x86 targets.
+    const Flags& Detect();
+}
+
+#endif
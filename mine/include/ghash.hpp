@@ -0,0 +1,31 @@
+#ifndef GHASH_HPP
+#define GHASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// GHASH, the GCM authenticator: Y <- (Y ^ X) * H over GF(2^128) for each 16-byte block X.
+// Values are 16-byte strings in GCM bit order. Uses PCLMULQDQ with four-block aggregated
+// reduction when the CPU has it, otherwise Shoup's 4-bit table method.
+namespace GHash {
+    enum class Method { Auto, Table, Clmul };
+
+    // Everything derived from H that the selected method needs
+    struct Key {
+        Method method;
+        alignas(16) uint8_t h[16];
+        alignas(16) uint8_t powers[4][16];  // H^1..H^4, byte-reversed, for the carry-less path
+        uint64_t table[16][2];              // i * H for 4-bit i, for the table path
+    };
+
+    // Throws if Clmul is requested on a CPU without it
+    void Init(Key& key, const uint8_t h[16], Method method = Method::Auto);
+
+    // Absorbs blocks * 16 bytes of data into state
+    void Update(const Key& key, uint8_t state[16], const uint8_t* data, size_t blocks);
+
+    // out = a * H^exponent; combines hashes of independent chunks. out may alias a.
+    void MultiplyByPower(const Key& key, const uint8_t a[16], uint64_t exponent, uint8_t out[16]);
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef KEY_STORE_HPP
+#define KEY_STORE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "m_rsa.hpp"
+
+// Persistent storage for M-RSA keys. A key file holds every field of a MultiPrimeKey,
+// CRT material included, so a receiver can build its PrivateKeyContext at startup
+// without generating primes or running any modular inversion:
+//
+//   "MRSAKEY1" | u32 prime count | n | e | d | primes[k] | exponents[k] | coefficients[k]
+//
+// Every field is a u32 little-endian length followed by big-endian magnitude bytes.
+// The file is read through a read-only memory mapping and written atomically through a
+// temporary file that only its owner can open, synced before and after it is renamed into
+// place, so a crash mid-save never leaves a truncated key behind.
+class KeyStore {
+public:
+    // Throws std::runtime_error if the file cannot be written
+    static void save(const std::string& path, const MultiPrimeKey& key);
+
+    // Throws std::runtime_error if the file is missing, truncated or malformed, or if the
+    // key in it fails MRSA::checkKey
+    static MultiPrimeKey load(const std::string& path);
+
+    // Loads path if it holds a valid key of this size and prime count; otherwise, including
+    // when the file is unreadable or damaged, generates one and saves it there
+    static MultiPrimeKey loadOrGenerate(const std::string& path, int keyLength, int primeCount = 3);
+};
+
+// Keeps up to depth freshly generated keys ready on a background thread, so rotating to
+// a new key costs a queue pop instead of a prime search. Generation runs one key at a
+// time and refills as keys are taken. A failed generation is retried after a pause that
+// doubles from 100 ms up to 30 s, until a key is produced or the pool is destroyed.
+class KeyPool {
+public:
+    KeyPool(int keyLength, size_t depth, int primeCount = 3);
+    ~KeyPool();
+
+    KeyPool(const KeyPool&) = delete;
+    KeyPool& operator=(const KeyPool&) = delete;
+
+    // Blocks only while the pool is empty. While the most recent generation attempt has
+    // failed, an empty pool rethrows that failure instead of blocking.
+    MultiPrimeKey take();
+
+    // Never blocks: returns false if no key is ready yet
+    bool tryTake(MultiPrimeKey& key);
+
+    size_t ready() const;
+
+private:
+    void run();
+
+    int keyLength;
+    int primeCount;
+    size_t depth;
+
+    mutable std::mutex mutex;
+    std::condition_variable refill;
+    std::condition_variable available;
+    std::deque<MultiPrimeKey> keys;
+    std::exception_ptr failure;
+    bool stopping = false;
+    std::thread worker;
+};
+
+#endif
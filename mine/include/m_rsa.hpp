@@ -3,41 +3,181 @@
 
 #include <vector>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include "thread_pool.hpp"
 
 // Forward declarations for OpenSSL types if we don't want to include full bn.h
 typedef struct bignum_st BIGNUM;
 typedef struct bignum_ctx BN_CTX;
 
-// The paper specifies using 3 primes for the RSA modulus
-struct TriplePrimeKey {
-    std::vector<uint8_t> n; // Modulus (a * b * c) 
+// The paper specifies using 3 primes for the RSA modulus; other counts are supported
+// for cheaper CRT decryption at larger modulus sizes
+struct MultiPrimeKey {
+    std::vector<uint8_t> n; // Modulus (product of the primes) 
     std::vector<uint8_t> e; // Public exponent 
     std::vector<uint8_t> d; // Private exponent 
-    std::vector<uint8_t> p; // Prime 1
-    std::vector<uint8_t> q; // Prime 2
-    std::vector<uint8_t> r; // Prime 3
+    std::vector<std::vector<uint8_t>> primes; // Prime factors, 2 to 5 of them
+
+    // CRT material filled in by generateKey: d mod (p_i - 1), and (p_0 ... p_(i-1))^-1 mod p_i
+    // (empty for i = 0). Optional; PrivateKeyContext derives whatever is missing.
+    std::vector<std::vector<uint8_t>> exponents;
+    std::vector<std::vector<uint8_t>> coefficients;
 };
 
+using TriplePrimeKey = MultiPrimeKey;
+
 class MRSA {
 public:
-    // Generate keys using the 3-prime method
-    static TriplePrimeKey generateKey(int keyLength);
+    static constexpr int MIN_PRIMES = 2;
+    static constexpr int MAX_PRIMES = 5;
+
+    // Largest prime count that keeps every factor out of reach of factoring methods that
+    // target small factors (ECM): 3 below 4096 bits, 4 below 8192, 5 from 8192 up
+    static int maxPrimesFor(int keyLength);
+
+    // Which arithmetic the key contexts run on. Auto takes the in-tree fixed-width
+    // Montgomery engine (mont.hpp) for private-key exponentiations at the prime widths
+    // where it beats OpenSSL and OpenSSL everywhere else; Native uses the engine for
+    // every width it covers, public-key encryption included. Contexts keep the choice in
+    // effect when they were constructed. The initial value can be forced with the
+    // MRSA_ARITHMETIC environment variable ("auto", "openssl", "native").
+    enum class Arithmetic { Auto, OpenSSL, Native };
+    static void setArithmetic(Arithmetic arithmetic);
+    static Arithmetic arithmetic();
+
+    // Scratch space for the BIGNUM paths: a BN_CTX whose pool is pre-grown for keys of
+    // up to keyLength bits, plus the Montgomery context of the last modulus encrypt was
+    // given. Calls that take one draw their temporaries from it and keep them pooled
+    // instead of freeing them, so repeated calls stop allocating once it is warm. Calls
+    // that handle private key material wipe every pooled temporary they used on return,
+    // OpenSSL's own included. Not thread-safe: local() gives each thread its own, and is
+    // the default everywhere.
+    class Workspace {
+    public:
+        explicit Workspace(int keyLength = 2048);
+        ~Workspace();
+
+        Workspace(Workspace&& other) noexcept;
+        Workspace& operator=(Workspace&& other) noexcept;
+        Workspace(const Workspace&) = delete;
+        Workspace& operator=(const Workspace&) = delete;
+
+        // The calling thread's workspace, created on first use
+        static Workspace& local();
+
+    private:
+        friend class MRSA;
+        struct Material;
+        std::unique_ptr<Material> material;
+    };
+
+    // Private-key material derived once from a MultiPrimeKey instead of on every decrypt:
+    // the CRT exponents d mod (p_i - 1), the recombination coefficients and a Montgomery
+    // context per prime. Immutable after construction, so one context can serve
+    // concurrent decrypt calls.
+    class PrivateKeyContext {
+    public:
+        explicit PrivateKeyContext(const MultiPrimeKey& key);
+        ~PrivateKeyContext();
+
+        PrivateKeyContext(PrivateKeyContext&& other) noexcept;
+        PrivateKeyContext& operator=(PrivateKeyContext&& other) noexcept;
+        PrivateKeyContext(const PrivateKeyContext&) = delete;
+        PrivateKeyContext& operator=(const PrivateKeyContext&) = delete;
+
+    private:
+        friend class MRSA;
+        struct Material;
+        std::unique_ptr<Material> material;
+    };
+
+    // The receiver's public key parsed once for repeated encryption: the modulus, its
+    // Montgomery context and working BIGNUMs sized for it. Small exponents (up to 64 bits,
+    // e.g. 65537) take a square-and-multiply path in the Montgomery domain, 16 squarings
+    // and one multiply for 65537. Encrypting reuses the cached storage, so it is not
+    // thread-safe: use one context per thread.
+    class PublicKeyContext {
+    public:
+        PublicKeyContext(const std::vector<uint8_t>& n, const std::vector<uint8_t>& e);
+        ~PublicKeyContext();
+
+        PublicKeyContext(PublicKeyContext&& other) noexcept;
+        PublicKeyContext& operator=(PublicKeyContext&& other) noexcept;
+        PublicKeyContext(const PublicKeyContext&) = delete;
+        PublicKeyContext& operator=(const PublicKeyContext&) = delete;
+
+        // Every ciphertext is exactly this many bytes, zero-padded on the left
+        size_t modulusBytes() const;
+
+    private:
+        friend class MRSA;
+        struct Material;
+        std::unique_ptr<Material> material;
+    };
+
+    // Generate keys using the multi-prime method, 3 primes by default. The primes are
+    // searched for concurrently, one pool task each, and the finished key must decrypt a
+    // random probe it encrypted. Throws std::invalid_argument if primeCount is outside
+    // [MIN_PRIMES, maxPrimesFor(keyLength)].
+    static MultiPrimeKey generateKey(int keyLength, int primeCount = 3, ThreadPool& pool = ThreadPool::shared(),
+                                     Workspace& workspace = Workspace::local());
+
+    // Fills in key.exponents and key.coefficients from d and the primes, for keys that
+    // were created without them
+    static void deriveCrtMaterial(MultiPrimeKey& key);
+
+    // For keys from outside generateKey, such as a key file: throws std::invalid_argument
+    // unless n is the product of the primes, e * d = 1 modulo every p_i - 1 and the CRT
+    // material (if present) matches d and the primes. Costs a few multiplications and
+    // reductions, no exponentiation; the primes are not tested for primality.
+    static void checkKey(const MultiPrimeKey& key, Workspace& workspace = Workspace::local());
 
     // Encrypt the S-AES key using the M-RSA public key
     // Uses OAEP padding with Hash 256 as per experimental settings
     static std::vector<uint8_t> encrypt(const std::vector<uint8_t>& plaintext, 
                                         const std::vector<uint8_t>& n, 
-                                        const std::vector<uint8_t>& e);
+                                        const std::vector<uint8_t>& e,
+                                        Workspace& workspace = Workspace::local());
+
+    // Encrypt with a cached public key. The pointer form writes publicKey.modulusBytes()
+    // bytes to ciphertext and allocates nothing. Throws std::invalid_argument unless the
+    // plaintext, read as a big-endian number, is below n.
+    static std::vector<uint8_t> encrypt(const std::vector<uint8_t>& plaintext, PublicKeyContext& publicKey);
+    static void encrypt(const uint8_t* plaintext, size_t length, uint8_t* ciphertext, PublicKeyContext& publicKey);
 
     // Decrypt the S-AES key using the M-RSA private key[cite: 425].
-    // Uses the full TriplePrimeKey for CRT optimization
+    // Uses the full MultiPrimeKey for CRT optimization
     static std::vector<uint8_t> decrypt(const std::vector<uint8_t>& ciphertext, 
-                                        const TriplePrimeKey& privateKey);
+                                        const MultiPrimeKey& privateKey,
+                                        Workspace& workspace = Workspace::local());
+
+    // How decrypt schedules the per-prime exponentiations. Parallel runs them as separate
+    // tasks on the pool, each worker with its own BN_CTX, so a single decrypt takes about
+    // as long as one exponentiation when the pool has a core per prime.
+    enum class CrtMode { Sequential, Parallel };
+
+    // Decrypt with precomputed key material: one constant-time modular exponentiation per
+    // prime on cached Montgomery contexts and the recombination. Parallel tasks use the
+    // workspace of the thread they run on.
+    static std::vector<uint8_t> decrypt(const std::vector<uint8_t>& ciphertext,
+                                        const PrivateKeyContext& privateKey,
+                                        CrtMode mode = CrtMode::Sequential,
+                                        ThreadPool& pool = ThreadPool::shared(),
+                                        Workspace& workspace = Workspace::local());
+
+    // Decrypts many ciphertexts under one key, such as the session keys of a burst of
+    // connections, with the same results as decrypt on each. On CPUs with AVX2 they go
+    // four at a time through MontLanes, one ciphertext per SIMD lane for each prime's
+    // exponentiation; elsewhere, and for one or two leftovers, they are decrypted one
+    // by one. Safe to call from several threads on one context.
+    static std::vector<std::vector<uint8_t>> decryptBatch(const std::vector<std::vector<uint8_t>>& ciphertexts,
+                                                          const PrivateKeyContext& privateKey,
+                                                          Workspace& workspace = Workspace::local());
 
 private:
-    // Internal math for the Euler function: φ(n) = (a-1)(b-1)(c-1).
-    static std::vector<uint8_t> calculateEuler(BIGNUM* a, BIGNUM* b, BIGNUM* c, BN_CTX* ctx);
+    // Internal math for the Euler function: φ(n) = (p_1-1)(p_2-1)...(p_k-1).
+    static std::vector<uint8_t> calculateEuler(const std::vector<BIGNUM*>& primes, Workspace& workspace);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,162 @@
+#ifndef MONT_HPP
+#define MONT_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Fixed-width Montgomery arithmetic for the M-RSA paths. Mont<N> works modulo an odd
+// number of at most N 64-bit limbs with R = 2^(64N); operands are std::arrays on the
+// stack, and every loop runs a compile-time trip count, so the compiler unrolls the
+// multiply and timing depends only on N and the modulus bit length, never on operand
+// values. Limbs are little-endian. Built on unsigned __int128, so it is only available
+// on compilers that provide it (MONT_NATIVE); elsewhere MontContext::supports is false
+// and callers keep using OpenSSL.
+#if defined(__SIZEOF_INT128__)
+#define MONT_NATIVE 1
+#endif
+
+template <size_t N>
+class Mont {
+public:
+    using Limbs = std::array<uint64_t, N>;
+
+    // Throws std::invalid_argument if the modulus is even or below 3
+    explicit Mont(const Limbs& modulus);
+
+    const Limbs& modulus() const { return m; }
+    const Limbs& one() const { return r1; }  // R mod m, 1 in Montgomery form
+
+    // a * b / R mod m. Inputs below m, or a below R when b is below m; out may alias either.
+    void mul(const Limbs& a, const Limbs& b, Limbs& out) const;
+    void sqr(const Limbs& a, Limbs& out) const;
+    void add(const Limbs& a, const Limbs& b, Limbs& out) const;
+    void sub(const Limbs& a, const Limbs& b, Limbs& out) const;
+
+    void toMont(const Limbs& a, Limbs& out) const { mul(a, r2, out); }
+    void fromMont(const Limbs& a, Limbs& out) const;
+
+    // value * R mod m for a value of any length: Horner over N-limb chunks, so a full
+    // RSA ciphertext reduces modulo one prime without a division
+    void reduceToMont(const uint64_t* value, size_t limbs, Limbs& out) const;
+
+    // base^exponent in Montgomery form, both in and out. Fixed windows over every bit
+    // position up to the modulus bit length, with the table entry picked by a full
+    // masked scan, so the exponent's value does not affect timing or memory access.
+    void pow(const Limbs& base, const Limbs& exponent, Limbs& out) const;
+
+    // Square-and-multiply for public exponents such as 65537: branches on exponent bits
+    void powPublic(const Limbs& base, uint64_t exponent, Limbs& out) const;
+
+private:
+    Limbs m;
+    Limbs r1;
+    Limbs r2;          // R^2 mod m
+    uint64_t m0inv;    // -m^-1 mod 2^64
+    size_t bits;       // bit length of m
+};
+
+// Runtime front end over the widths compiled into mont.cpp: a modulus of up to
+// MAX_LIMBS limbs runs on the smallest Mont<N> that holds it. Arguments are raw limb
+// pointers; width() is the number of limbs every result and exponent takes.
+class MontContext {
+public:
+    static constexpr size_t MAX_LIMBS = 32;
+
+    // True if a modulus of this many significant limbs has an engine here
+    static bool supports(size_t limbs);
+
+    // True where modExp is expected to beat OpenSSL's constant-time exponentiation.
+    // OpenSSL has dedicated assembly (RSAZ) for moduli that are a multiple of 512 bits,
+    // which wins there; its generic path loses to Mont<N> at the other widths measured on
+    // x86-64. Single multiplies are still faster in OpenSSL's assembly, and a modulus
+    // that has to be padded up to the next compiled width is not preferred.
+    static bool preferred(size_t limbs);
+
+    // Big-endian bytes to little-endian limbs and back, zero-padded to the given width.
+    // fromBytes throws std::invalid_argument if the value does not fit.
+    static void fromBytes(const uint8_t* bytes, size_t length, uint64_t* out, size_t limbs);
+    static void toBytes(const uint64_t* value, size_t limbs, uint8_t* out, size_t length);
+
+    // acc += a * b over accLimbs limbs; the caller guarantees the sum fits
+    static void mulAdd(uint64_t* acc, size_t accLimbs, const uint64_t* a, size_t aLimbs, const uint64_t* b, size_t bLimbs);
+
+    // Throws std::invalid_argument if the modulus is even or too wide
+    MontContext(const uint64_t* modulus, size_t limbs);
+    ~MontContext();
+
+    MontContext(MontContext&& other) noexcept;
+    MontContext& operator=(MontContext&& other) noexcept;
+    MontContext(const MontContext&) = delete;
+    MontContext& operator=(const MontContext&) = delete;
+
+    size_t width() const;
+
+    // value mod m, in normal form
+    void reduce(const uint64_t* value, size_t limbs, uint64_t* out) const;
+
+    // (a - b) * factor mod m for a, b below m; factor as returned by prepareFactor
+    void mulDifference(const uint64_t* a, const uint64_t* b, const uint64_t* factor, uint64_t* out) const;
+
+    // factor in the form mulDifference expects (its Montgomery form)
+    void prepareFactor(const uint64_t* factor, uint64_t* out) const;
+
+    // base^exponent mod m for a base of any length; constant time in the exponent,
+    // which takes width() limbs
+    void modExp(const uint64_t* base, size_t baseLimbs, const uint64_t* exponent, uint64_t* out) const;
+
+    // base^exponent mod m for a public exponent; base of any length
+    void modExpPublic(const uint64_t* base, size_t baseLimbs, uint64_t exponent, uint64_t* out) const;
+
+    struct Engine;
+
+private:
+    std::unique_ptr<Engine> engine;
+};
+
+// Four modular exponentiations at once under one modulus and one exponent, each in a
+// 64-bit lane of an AVX2 register (mont_avx2.cpp). Numbers are held as 29-bit digits, so
+// every digit product from VPMULUDQ fits in 58 bits and a column can absorb dozens of
+// them before a carry pass. Meant for the CRT step of batched decryption, where each
+// lane is a different ciphertext reduced modulo the same prime; the exponent is shared,
+// so the window schedule and table scan are the same in every lane.
+class MontLanes {
+public:
+    static constexpr size_t LANES = 4;
+    static constexpr size_t MAX_LIMBS = MontContext::MAX_LIMBS;
+
+    // True if this build and CPU can run it: x86 with AVX2 enabled by the OS
+    static bool available();
+
+    // True if available and a modulus of this many significant limbs fits
+    static bool supports(size_t limbs);
+
+    // True where four lanes take less than four of MontContext's or OpenSSL's single
+    // exponentiations. That holds from 256-bit moduli up, except at multiples of 512
+    // bits, where OpenSSL's RSAZ assembly keeps up with the lanes.
+    static bool preferred(size_t limbs);
+
+    // Throws std::invalid_argument if the modulus is even, below 3 or wider than
+    // MAX_LIMBS, and std::runtime_error if the engine is not available
+    MontLanes(const uint64_t* modulus, size_t count);
+
+    // Limbs taken by every base, exponent and result: the modulus's significant limbs
+    size_t width() const { return limbs; }
+
+    // out[l] = bases[l]^exponent mod m for each lane l, with every base below m. Constant
+    // time in the exponent and the bases. out may alias bases.
+    void modExp(const uint64_t* const bases[LANES], const uint64_t* exponent, uint64_t* const out[LANES]) const;
+
+private:
+    size_t limbs;       // 64-bit limbs of m
+    size_t digits;      // 29-bit digits per number, with R = 2^(29 * digits) > 4m
+    size_t bits;        // bit length of m
+    uint64_t m0inv;     // -m^-1 mod 2^29
+    std::vector<uint64_t> m;   // modulus digits
+    std::vector<uint64_t> r1;  // R mod m, as digits
+    std::vector<uint64_t> r2;  // R^2 mod m, as digits
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// CPU and memory placement for the cipher workers. On Linux the topology is read from
+// /sys/devices/system/node and memory policy is set with mbind; elsewhere, or when /sys
+// reports a single node, everything degrades to one node holding every CPU and the
+// placement calls become no-ops.
+namespace Numa {
+    struct Topology {
+        std::vector<std::vector<unsigned int>> nodeCpus;  // CPUs of each node, ascending
+        std::vector<int> cpuNode;                         // node of each CPU, -1 if offline or unknown
+
+        size_t nodeCount() const { return nodeCpus.size(); }
+        bool multiNode() const { return nodeCpus.size() > 1; }
+    };
+
+    // Read once and cached
+    const Topology& Detect();
+
+    // Parses a kernel-style CPU list such as "0-3,8,10-11"; throws on malformed input
+    std::vector<unsigned int> ParseCpuList(const std::string& list);
+
+    int NodeOfCpu(unsigned int cpu);
+
+    // Node whose memory backs the page holding address: always 0 on a single node, -1 if
+    // the page is not yet faulted in or the kernel cannot tell
+    int NodeOfAddress(const void* address);
+
+    // Restricts the calling thread to one CPU. Returns false where pinning is unsupported.
+    bool PinCurrentThread(unsigned int cpu);
+
+    // Page-aligned allocations with a memory policy: on one node, or interleaved page by
+    // page across all nodes for buffers that every worker touches. Policies only apply on
+    // multi-node Linux machines; otherwise these are plain allocations.
+    void* Allocate(size_t bytes, int node);
+    void* AllocateInterleaved(size_t bytes);
+    void Free(void* data, size_t bytes);
+
+    // Owning wrapper for input/output buffers
+    class Buffer {
+    public:
+        Buffer() = default;
+        Buffer(size_t size, int node);
+        static Buffer Interleaved(size_t size);
+        ~Buffer();
+
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        unsigned char* data() { return bytes; }
+        const unsigned char* data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        unsigned char* bytes = nullptr;
+        size_t length = 0;
+    };
+}
+
+#endif
@@ -1,31 +1,221 @@
 #ifndef S_AES_HPP
 #define S_AES_HPP
 
+#include <array>
 #include <vector>
 #include <cstdint>
+#include <condition_variable>
 #include <future>
+#include <mutex>
+#include <optional>
+#include "thread_pool.hpp"
 
+namespace AESCore { template <int Rounds> struct BlockKernel; }
+namespace Autotune { struct Params; }
+namespace GHash { struct Key; }
+
+// The round count is a template parameter so every round loop is unrolled at compile
+// time and the key schedule has a fixed size. SAES<> is the 7-round S-AES variant;
+// 10/12/14 give standard AES-128/192/256. Defined for 7, 10, 12 and 14 only.
+template <int Rounds = 7>
 class SAES {
 public:
-    // Initialize with a 128-bit key
-    explicit SAES(const std::vector<uint8_t>& key);
+    static constexpr int ROUNDS = Rounds;
+    static constexpr size_t KEY_SIZE = Rounds == 12 ? 24 : (Rounds == 14 ? 32 : 16);
+
+    // Initialize with a KEY_SIZE-byte key (128-bit for S-AES). Large messages are split
+    // across the given pool, by default the process-wide one.
+    explicit SAES(const std::vector<uint8_t>& key, ThreadPool& threadPool = ThreadPool::shared());
 
-    // Encrypts using CTR mode, 7 rounds, multi-threaded
+    // Encrypts using CTR mode, multi-threaded
     std::vector<uint8_t> encrypt(const std::vector<uint8_t>& plaintext, const std::vector<uint8_t>& iv);
 
-    // Decrypts using CTR mode, 7 rounds, multi-threaded
+    // Decrypts using CTR mode, multi-threaded
     std::vector<uint8_t> decrypt(const std::vector<uint8_t>& ciphertext, const std::vector<uint8_t>& iv);
 
+    // Caller-owned buffers: length bytes from input to output under a 16-byte iv.
+    // output may equal input for in-place operation but must not otherwise overlap it.
+    void encrypt(const uint8_t* input, size_t length, const uint8_t* iv, uint8_t* output);
+    void decrypt(const uint8_t* input, size_t length, const uint8_t* iv, uint8_t* output);
+
+    // Authenticated encryption in GCM (standard AES-GCM for SAES<10/12/14>): the CTR
+    // keystream XOR and the GHASH of the ciphertext run in the same pass over each range,
+    // ranges are split across the thread pool and their partial hashes are combined with
+    // powers of H. Any non-empty iv length is accepted; 12 bytes is the standard choice.
+    static constexpr size_t TAG_SIZE = 16;
+    void encryptAuthenticated(const uint8_t* input, size_t length, const uint8_t* iv, size_t ivLength,
+                              const uint8_t* aad, size_t aadLength, uint8_t* output, uint8_t* tag);
+
+    // Verifies the tag in the same pass as decryption; on mismatch the output is wiped
+    // and std::runtime_error is thrown
+    void decryptAuthenticated(const uint8_t* input, size_t length, const uint8_t* iv, size_t ivLength,
+                              const uint8_t* aad, size_t aadLength, const uint8_t* tag, uint8_t* output);
+
+    // Vector forms: the ciphertext is followed by the TAG_SIZE-byte tag
+    std::vector<uint8_t> encryptAuthenticated(const std::vector<uint8_t>& plaintext, const std::vector<uint8_t>& iv,
+                                              const std::vector<uint8_t>& aad = {});
+    std::vector<uint8_t> decryptAuthenticated(const std::vector<uint8_t>& sealed, const std::vector<uint8_t>& iv,
+                                              const std::vector<uint8_t>& aad = {});
+
+    // Expanded encryption key for batch jobs. Held by value, so a gateway can keep one per
+    // session key without a heap allocation; wiped on destruction.
+    struct KeySchedule {
+        explicit KeySchedule(const uint8_t* key, size_t keyLength = KEY_SIZE);
+        explicit KeySchedule(const std::vector<uint8_t>& key);
+        ~KeySchedule();
+
+        alignas(16) std::array<uint8_t, 16 * (Rounds + 1)> roundKeys;
+    };
+
+    // One message of a batch: length bytes from input to output under its own key and
+    // 16-byte iv. output may equal input but must not otherwise overlap any buffer in the batch.
+    struct BatchJob {
+        const KeySchedule* key;
+        const uint8_t* iv;
+        const uint8_t* input;
+        uint8_t* output;
+        size_t length;
+    };
+
+    // CTR over many independent messages at once. Counter blocks from consecutive jobs are
+    // packed into shared kernel calls, each block with its own key schedule, so a batch of
+    // 64-byte messages keeps the interleaved pipeline as full as one large message would.
+    // Above the autotuned cutoff the batch is split by block count across the pool.
+    static void encryptBatch(const BatchJob* jobs, size_t count, ThreadPool& threadPool = ThreadPool::shared());
+    static void decryptBatch(const BatchJob* jobs, size_t count, ThreadPool& threadPool = ThreadPool::shared());
+
+    // Parallelism thresholds in effect for this instance's backend
+    const Autotune::Params& tuning() const;
+
+    // Incremental CTR over an unbounded message; defined below
+    class CtrStream;
+
+    // CTR session with keystream computed ahead of the data; defined below
+    class KeystreamBuffer;
+
 private:
-    static constexpr int ROUNDS = 7; 
-    std::vector<uint8_t> expandedKey;
+    alignas(16) std::array<uint8_t, 16 * (Rounds + 1)> expandedKey;
+    alignas(16) std::array<uint8_t, 16 * (Rounds + 1)> decryptionKey; // Equivalent inverse cipher schedule
+    const AESCore::BlockKernel<Rounds>* kernel;  // Backend resolved at construction
+    ThreadPool* pool;
+    const Autotune::Params* tuningParams;        // Measured on first use of the backend with this pool size
 
     // Single block transformations mapped to Algorithm 1 and 2
     void encryptBlock(const uint8_t* input, uint8_t* output) const;
     void decryptBlock(const uint8_t* input, uint8_t* output) const;
 
-    // Thread pool orchestration for CTR processing
-    void processBlocksParallel(const std::vector<uint8_t>& input, std::vector<uint8_t>& output, const std::vector<uint8_t>& iv);
+    // Encrypts n independent counter blocks through the backend's interleaved kernel
+    static constexpr size_t CTR_BATCH = 32;
+    void encryptBlocks(const uint8_t* ctrs, uint8_t* out, size_t n) const;
+
+    // CTR keystream XOR for length bytes starting at counter block startBlock
+    void ctrXor(const uint8_t* iv, uint64_t startBlock, const uint8_t* input, uint8_t* output, size_t length) const;
+
+    // GCM counter mode (32-bit increment from J0 + 1 + startBlock) over length bytes,
+    // absorbing the ciphertext into hashState batch by batch while it is still in cache
+    void gcmXor(const uint8_t* j0, uint64_t startBlock, const uint8_t* input, uint8_t* output, size_t length,
+                const GHash::Key& hashKey, uint8_t* hashState, bool encrypting) const;
+
+    // Shared GCM driver; writes the computed tag
+    void gcmProcess(const uint8_t* input, size_t length, const uint8_t* iv, size_t ivLength,
+                    const uint8_t* aad, size_t aadLength, uint8_t* output, uint8_t* tag, bool encrypting);
+
+    // Processes numBlocks counter blocks of the batch, starting offset bytes into jobs[job]
+    static void batchXor(const AESCore::BlockKernel<Rounds>& kernel, const BatchJob* jobs, size_t count,
+                         size_t job, size_t offset, size_t numBlocks);
+    static void processBatch(const BatchJob* jobs, size_t count, ThreadPool& threadPool);
+
+    // Splits the message, which starts at counter block startBlock, into counter ranges
+    // and runs them on the thread pool
+    void processBlocksParallel(const uint8_t* input, size_t length, const uint8_t* iv, uint64_t startBlock, uint8_t* output);
 };
 
+// Stateful CTR context: update() accepts chunks of any length and carries the keystream
+// position between calls, so a message can be processed as it is produced with memory
+// bounded by the chunk size. Produces the same bytes as a one-shot encrypt of the
+// concatenated chunks; encryption and decryption are the same operation.
+template <int Rounds>
+class SAES<Rounds>::CtrStream {
+public:
+    CtrStream() = default;
+    CtrStream(const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv, ThreadPool& threadPool = ThreadPool::shared());
+
+    // (Re)keys the stream and rewinds it to byte 0. The iv must be 16 bytes.
+    void init(const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv, ThreadPool& threadPool = ThreadPool::shared());
+
+    // XORs the next length bytes of keystream into output; output may equal input
+    void update(const uint8_t* input, uint8_t* output, size_t length);
+
+    // Moves to an absolute byte offset in the message, for random access
+    void seek(uint64_t byteOffset);
+    uint64_t position() const { return offset; }
+
+private:
+    std::optional<SAES<Rounds>> cipher;
+    std::array<uint8_t, 16> iv{};
+    uint64_t offset = 0;
+
+    // Keystream of the block holding a chunk boundary, reused by the next update()
+    alignas(16) std::array<uint8_t, 16> keystream{};
+    uint64_t keystreamBlock = 0;
+    bool keystreamValid = false;
+
+    const uint8_t* keystreamFor(uint64_t block);
+};
+
+// CTR session whose keystream is generated ahead of time into a ring of depthBlocks
+// blocks by a background task on the thread pool. While the ring holds enough keystream,
+// update() is a single XOR; a message longer than what is buffered falls back to
+// computing the remainder inline. Messages consume keystream back to back, so
+// position() is the byte offset (counter block position() / 16 past the iv) at which
+// the next message starts. close() or destruction wipes the buffered keystream.
+template <int Rounds>
+class SAES<Rounds>::KeystreamBuffer {
+public:
+    KeystreamBuffer(const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv, size_t depthBlocks = 256,
+                    ThreadPool& threadPool = ThreadPool::shared());
+    ~KeystreamBuffer();
+
+    KeystreamBuffer(const KeystreamBuffer&) = delete;
+    KeystreamBuffer& operator=(const KeystreamBuffer&) = delete;
+
+    // XORs the next length bytes of keystream into output; output may equal input
+    void update(const uint8_t* input, uint8_t* output, size_t length);
+
+    uint64_t position() const;
+    // Keystream bytes ready for immediate use
+    size_t available() const;
+
+    // Waits for an in-flight refill, then wipes the ring; update() throws afterwards
+    void close();
+
+private:
+    SAES<Rounds> cipher;
+    ThreadPool* pool;
+    std::array<uint8_t, 16> iv{};
+
+    // ring[i % capacity] holds keystream byte i for consumed <= i < produced.
+    // produced is always block aligned; consumed advances a byte at a time.
+    std::vector<uint8_t> ring;
+    std::vector<uint8_t> scratch;     // written only by the single in-flight refill
+    size_t capacity;
+    uint64_t produced = 0;
+    uint64_t consumed = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable workDone;  // signalled when a refill or an inline computation ends
+    bool refillPending = false;
+    size_t inlineActive = 0;          // update() calls computing reserved keystream outside the lock
+    bool closed = false;
+    uint64_t generation = 0;          // bumped when the ring is bypassed, voiding in-flight refills
+
+    bool needsRefill() const;
+    void scheduleRefill();
+    void refill();
+};
+
+using AES128 = SAES<10>;
+using AES192 = SAES<12>;
+using AES256 = SAES<14>;
+
 #endif
\ No newline at end of file
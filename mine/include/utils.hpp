@@ -17,6 +17,9 @@ namespace Utils {
 
     //Converts Hex strings back to byte arrays.
     std::vector<uint8_t> fromHexString(const std::string& hex);
+
+    //Overwrites key material with zeros in a way the compiler cannot drop as a dead store.
+    void secureZero(void* data, size_t length);
 }
 
 #endif // UTILS_HPP
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "aes_core.hpp"
+#include "cpu_features.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace AESCore {
+
+static Backend Resolve(Backend backend) {
+    if (backend != Backend::Auto) return backend;
+    const CpuFeatures::Flags& cpu = CpuFeatures::Detect();
+    if (cpu.aesni) return Backend::AESNI;
+    return cpu.ssse3 ? Backend::VPerm : Backend::TTable;
+}
+
+// Multi-key fallback for engines whose batching shares one schedule: consecutive blocks
+// under the same key (the common case, one message after another) go through the
+// engine's interleaved path together.
+template <int Rounds, void (*EncryptBlocks)(const uint8_t*, const uint8_t*, uint8_t*, size_t)>
+static void EncryptBlocksByKey(const uint8_t* const* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks) {
+    size_t begin = 0;
+    while (begin < numBlocks) {
+        size_t end = begin + 1;
+        while (end < numBlocks && roundKeys[end] == roundKeys[begin]) ++end;
+        EncryptBlocks(roundKeys[begin], input + (begin * 16), output + (begin * 16), end - begin);
+        begin = end;
+    }
+}
+
+// One kernel table per round count; the function pointers are fully specialized,
+// so the round loops inside each engine are unrolled at compile time.
+template <int Rounds>
+static const BlockKernel<Rounds>& KernelFor(Backend backend) {
+    static const BlockKernel<Rounds> referenceKernel = { Backend::Reference, EncryptBlockRef<Rounds>, DecryptBlockRef<Rounds>, EncryptBlocksRef<Rounds>,
+                                                         EncryptBlocksByKey<Rounds, EncryptBlocksRef<Rounds>> };
+    static const BlockKernel<Rounds> ttableKernel    = { Backend::TTable,    EncryptBlockT<Rounds>,   DecryptBlockT<Rounds>,   EncryptBlocksT<Rounds>,
+                                                         EncryptBlocksByKey<Rounds, EncryptBlocksT<Rounds>> };
+    static const BlockKernel<Rounds> aesniKernel     = { Backend::AESNI,     EncryptBlockNI<Rounds>,  DecryptBlockNI<Rounds>,  EncryptBlocksNI<Rounds>,
+                                                         EncryptBlocksMultiKeyNI<Rounds> };
+    static const BlockKernel<Rounds> vpermKernel     = { Backend::VPerm,     EncryptBlockVP<Rounds>,  DecryptBlockVP<Rounds>,  EncryptBlocksVP<Rounds>,
+                                                         EncryptBlocksByKey<Rounds, EncryptBlocksVP<Rounds>> };
+    static const BlockKernel<Rounds> bitsliceKernel  = { Backend::Bitslice,  EncryptBlockBS<Rounds>,  DecryptBlockBS<Rounds>,  EncryptBlocksBS<Rounds>,
+                                                         EncryptBlocksByKey<Rounds, EncryptBlocksBS<Rounds>> };
+
+    switch (backend) {
+        case Backend::Reference: return referenceKernel;
+        case Backend::TTable:    return ttableKernel;
+        case Backend::AESNI:     return aesniKernel;
+        case Backend::VPerm:     return vpermKernel;
+        case Backend::Bitslice:  return bitsliceKernel;
+        case Backend::Auto:      break;
+    }
+    return KernelFor<Rounds>(Resolve(backend));
+}
+
+static Backend ParseBackend(const char* name) {
+    std::string value(name);
+    if (value == "auto") return Backend::Auto;
+    if (value == "reference") return Backend::Reference;
+    if (value == "ttable") return Backend::TTable;
+    if (value == "aesni") return Backend::AESNI;
+    if (value == "vperm") return Backend::VPerm;
+    if (value == "bitslice") return Backend::Bitslice;
+    throw std::invalid_argument("Unknown SAES_BACKEND value: " + value);
+}
+
+static Backend InitialBackend() {
+    const char* env = std::getenv("SAES_BACKEND");
+    Backend backend = (env && *env) ? ParseBackend(env) : Backend::Auto;
+    if (!IsBackendSupported(backend)) {
+        throw std::runtime_error(std::string("SAES_BACKEND requests an unsupported backend: ") + env);
+    }
+    return Resolve(backend);
+}
+
+static std::atomic<Backend>& CurrentBackend() {
+    static std::atomic<Backend> current(InitialBackend());
+    return current;
+}
+
+bool IsBackendSupported(Backend backend) {
+    if (backend == Backend::AESNI) return CpuFeatures::Detect().aesni;
+    if (backend == Backend::VPerm) return CpuFeatures::Detect().ssse3;
+    return true;
+}
+
+const char* BackendName(Backend backend) {
+    switch (backend) {
+        case Backend::Auto:      return "auto";
+        case Backend::Reference: return "reference";
+        case Backend::TTable:    return "ttable";
+        case Backend::AESNI:     return "aesni";
+        case Backend::VPerm:     return "vperm";
+        case Backend::Bitslice:  return "bitslice";
+    }
+    return "unknown";
+}
+
+void SetBackend(Backend backend) {
+    if (!IsBackendSupported(backend)) {
+        throw std::invalid_argument(std::string("Backend not supported on this CPU: ") + BackendName(backend));
+    }
+    CurrentBackend().store(Resolve(backend));
+}
+
+Backend ActiveBackend() {
+    return CurrentBackend().load();
+}
+
+template <int Rounds>
+const BlockKernel<Rounds>& ActiveKernel() {
+    return KernelFor<Rounds>(CurrentBackend().load());
+}
+
+template const BlockKernel<7>& ActiveKernel<7>();
+template const BlockKernel<10>& ActiveKernel<10>();
+template const BlockKernel<12>& ActiveKernel<12>();
+template const BlockKernel<14>& ActiveKernel<14>();
+
+} // namespace AESCore
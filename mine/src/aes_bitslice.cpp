@@ -0,0 +1,453 @@
+#include "aes_core.hpp"
+#include "aes_tower.hpp"
+#include <cstring>
+
+namespace AESCore {
+
+// Bitsliced engine: pure 64-bit integer code for cores without AES instructions or SIMD.
+// Four blocks are processed together as eight uint64_t planes; plane b holds bit b of
+// all 64 state bytes, with state byte (row, col) of block k at bit 16*row + 4*col + k.
+// SubBytes becomes a boolean circuit evaluated on all 64 bytes at once, ShiftRows a
+// rotation inside each 16-bit row group and the MixColumns row rotations plain 64-bit
+// rotates. There are no table lookups, so timing does not depend on key or data.
+
+static constexpr int BS_BLOCKS = 4;
+
+// S-box circuit of Boyar and Peralta (113 gates: 32 AND, 81 XOR). x0 is the most
+// significant bit. The affine constant 0x63 is omitted here and folded into the round keys.
+static inline void SBoxCircuit(uint64_t* q) {
+    uint64_t x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4];
+    uint64_t x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+    // Top linear transformation
+    uint64_t y14 = x3 ^ x5;
+    uint64_t y13 = x0 ^ x6;
+    uint64_t y9 = x0 ^ x3;
+    uint64_t y8 = x0 ^ x5;
+    uint64_t t0 = x1 ^ x2;
+    uint64_t y1 = t0 ^ x7;
+    uint64_t y4 = y1 ^ x3;
+    uint64_t y12 = y13 ^ y14;
+    uint64_t y2 = y1 ^ x0;
+    uint64_t y5 = y1 ^ x6;
+    uint64_t y3 = y5 ^ y8;
+    uint64_t t1 = x4 ^ y12;
+    uint64_t y15 = t1 ^ x5;
+    uint64_t y20 = t1 ^ x1;
+    uint64_t y6 = y15 ^ x7;
+    uint64_t y10 = y15 ^ t0;
+    uint64_t y11 = y20 ^ y9;
+    uint64_t y7 = x7 ^ y11;
+    uint64_t y17 = y10 ^ y11;
+    uint64_t y19 = y10 ^ y8;
+    uint64_t y16 = t0 ^ y11;
+    uint64_t y21 = y13 ^ y16;
+    uint64_t y18 = x0 ^ y16;
+
+    // Shared non-linear section (GF(2^4) inversion)
+    uint64_t t2 = y12 & y15;
+    uint64_t t3 = y3 & y6;
+    uint64_t t4 = t3 ^ t2;
+    uint64_t t5 = y4 & x7;
+    uint64_t t6 = t5 ^ t2;
+    uint64_t t7 = y13 & y16;
+    uint64_t t8 = y5 & y1;
+    uint64_t t9 = t8 ^ t7;
+    uint64_t t10 = y2 & y7;
+    uint64_t t11 = t10 ^ t7;
+    uint64_t t12 = y9 & y11;
+    uint64_t t13 = y14 & y17;
+    uint64_t t14 = t13 ^ t12;
+    uint64_t t15 = y8 & y10;
+    uint64_t t16 = t15 ^ t12;
+    uint64_t t17 = t4 ^ t14;
+    uint64_t t18 = t6 ^ t16;
+    uint64_t t19 = t9 ^ t14;
+    uint64_t t20 = t11 ^ t16;
+    uint64_t t21 = t17 ^ y20;
+    uint64_t t22 = t18 ^ y19;
+    uint64_t t23 = t19 ^ y21;
+    uint64_t t24 = t20 ^ y18;
+    uint64_t t25 = t21 ^ t22;
+    uint64_t t26 = t21 & t23;
+    uint64_t t27 = t24 ^ t26;
+    uint64_t t28 = t25 & t27;
+    uint64_t t29 = t28 ^ t22;
+    uint64_t t30 = t23 ^ t24;
+    uint64_t t31 = t22 ^ t26;
+    uint64_t t32 = t31 & t30;
+    uint64_t t33 = t32 ^ t24;
+    uint64_t t34 = t23 ^ t33;
+    uint64_t t35 = t27 ^ t33;
+    uint64_t t36 = t24 & t35;
+    uint64_t t37 = t36 ^ t34;
+    uint64_t t38 = t27 ^ t36;
+    uint64_t t39 = t29 & t38;
+    uint64_t t40 = t25 ^ t39;
+    uint64_t t41 = t40 ^ t37;
+    uint64_t t42 = t29 ^ t33;
+    uint64_t t43 = t29 ^ t40;
+    uint64_t t44 = t33 ^ t37;
+    uint64_t t45 = t42 ^ t41;
+    uint64_t z0 = t44 & y15;
+    uint64_t z1 = t37 & y6;
+    uint64_t z2 = t33 & x7;
+    uint64_t z3 = t43 & y16;
+    uint64_t z4 = t40 & y1;
+    uint64_t z5 = t29 & y7;
+    uint64_t z6 = t42 & y11;
+    uint64_t z7 = t45 & y17;
+    uint64_t z8 = t41 & y10;
+    uint64_t z9 = t44 & y12;
+    uint64_t z10 = t37 & y3;
+    uint64_t z11 = t33 & y4;
+    uint64_t z12 = t43 & y13;
+    uint64_t z13 = t40 & y5;
+    uint64_t z14 = t29 & y2;
+    uint64_t z15 = t42 & y9;
+    uint64_t z16 = t45 & y14;
+    uint64_t z17 = t41 & y8;
+
+    // Bottom linear transformation
+    uint64_t t46 = z15 ^ z16;
+    uint64_t t47 = z10 ^ z11;
+    uint64_t t48 = z5 ^ z13;
+    uint64_t t49 = z9 ^ z10;
+    uint64_t t50 = z2 ^ z12;
+    uint64_t t51 = z2 ^ z5;
+    uint64_t t52 = z7 ^ z8;
+    uint64_t t53 = z0 ^ z3;
+    uint64_t t54 = z6 ^ z7;
+    uint64_t t55 = z16 ^ z17;
+    uint64_t t56 = z12 ^ t48;
+    uint64_t t57 = t50 ^ t53;
+    uint64_t t58 = z4 ^ t46;
+    uint64_t t59 = z3 ^ t54;
+    uint64_t t60 = t46 ^ t57;
+    uint64_t t61 = z14 ^ t57;
+    uint64_t t62 = t52 ^ t58;
+    uint64_t t63 = t49 ^ t58;
+    uint64_t t64 = z4 ^ t59;
+    uint64_t t65 = t61 ^ t62;
+    uint64_t t66 = z1 ^ t63;
+    uint64_t s0 = t59 ^ t63;
+    uint64_t s6 = t56 ^ t62;
+    uint64_t s7 = t48 ^ t60;
+    uint64_t t67 = t64 ^ t65;
+    uint64_t s3 = t53 ^ t66;
+    uint64_t s4 = t51 ^ t66;
+    uint64_t s5 = t47 ^ t65;
+    uint64_t s1 = t64 ^ s3;
+    uint64_t s2 = t55 ^ t67;
+
+    q[7] = s0; q[6] = s1; q[5] = s2; q[4] = s3;
+    q[3] = s4; q[2] = s5; q[1] = s6; q[0] = s7;
+}
+
+// GF(2)-linear map on bit planes: out bit r = parity(rows[r] & in)
+struct BitMatrix {
+    uint8_t rows[8];
+};
+
+template <typename F>
+constexpr BitMatrix MakeMatrix(F f) {
+    BitMatrix m{};
+    for (int c = 0; c < 8; ++c) {
+        uint8_t column = f(static_cast<uint8_t>(1 << c));
+        for (int r = 0; r < 8; ++r) {
+            if (column & (1 << r)) m.rows[r] = static_cast<uint8_t>(m.rows[r] | (1 << c));
+        }
+    }
+    return m;
+}
+
+static constexpr BitMatrix invAffine = MakeMatrix(Tower::InvAffine);
+
+// The matrix is a compile-time constant, so the XOR network is fully resolved
+template <const BitMatrix& M>
+static inline void ApplyLinear(uint64_t* q) {
+    uint64_t in[8];
+    for (int b = 0; b < 8; ++b) in[b] = q[b];
+    Unroll<0, 8>([&](auto row) {
+        constexpr int R = decltype(row)::value;
+        uint64_t v = 0;
+        Unroll<0, 8>([&](auto col) {
+            constexpr int C = decltype(col)::value;
+            if constexpr (((M.rows[R] >> C) & 1) != 0) v ^= in[C];
+        });
+        q[R] = v;
+    });
+}
+
+// Without the constants, S(x) = A(x^-1) and InvS(y) = (A^-1 y)^-1, so
+// InvS = A^-1 o S o A^-1 reuses the forward circuit.
+static inline void InvSBoxCircuit(uint64_t* q) {
+    ApplyLinear<invAffine>(q);
+    SBoxCircuit(q);
+    ApplyLinear<invAffine>(q);
+}
+
+static inline uint64_t Rotr64(uint64_t x, int n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+// Row r rotates left by r columns: new column c <- old column c + r
+static inline uint64_t ShiftRowsPlane(uint64_t x) {
+    return (x & 0x000000000000ffffULL) |
+           ((x >> 4) & 0x000000000fff0000ULL) | ((x << 12) & 0x00000000f0000000ULL) |
+           ((x >> 8) & 0x000000ff00000000ULL) | ((x << 8) & 0x0000ff0000000000ULL) |
+           ((x >> 12) & 0x000f000000000000ULL) | ((x << 4) & 0xfff0000000000000ULL);
+}
+
+static inline uint64_t InvShiftRowsPlane(uint64_t x) {
+    return (x & 0x000000000000ffffULL) |
+           ((x << 4) & 0x00000000fff00000ULL) | ((x >> 12) & 0x00000000000f0000ULL) |
+           ((x >> 8) & 0x000000ff00000000ULL) | ((x << 8) & 0x0000ff0000000000ULL) |
+           ((x << 12) & 0xf000000000000000ULL) | ((x >> 4) & 0x0fff000000000000ULL);
+}
+
+// Multiplication by x across planes
+static inline void XtimeBS(const uint64_t* a, uint64_t* r) {
+    r[0] = a[7];
+    r[1] = a[0] ^ a[7];
+    r[2] = a[1];
+    r[3] = a[2] ^ a[7];
+    r[4] = a[3] ^ a[7];
+    r[5] = a[4];
+    r[6] = a[5];
+    r[7] = a[6];
+}
+
+// out_r = 2(a_r ^ a_r+1) ^ a_r+1 ^ a_r+2 ^ a_r+3; row r+k is a rotation by 16k bits
+static inline void MixColumnsBS(uint64_t* q) {
+    uint64_t r1[8], t[8], t2[8];
+    for (int b = 0; b < 8; ++b) {
+        r1[b] = Rotr64(q[b], 16);
+        t[b] = q[b] ^ r1[b];
+    }
+    XtimeBS(t, t2);
+    for (int b = 0; b < 8; ++b) q[b] = t2[b] ^ r1[b] ^ Rotr64(t[b], 32);
+}
+
+// InvMixColumns = MixColumns after a_r ^= 4(a_r ^ a_r+2)
+static inline void InvMixColumnsBS(uint64_t* q) {
+    uint64_t t[8], t2[8], t4[8];
+    for (int b = 0; b < 8; ++b) t[b] = q[b] ^ Rotr64(q[b], 32);
+    XtimeBS(t, t2);
+    XtimeBS(t2, t4);
+    for (int b = 0; b < 8; ++b) q[b] ^= t4[b];
+    MixColumnsBS(q);
+}
+
+static inline uint64_t LoadLE64(const uint8_t* p) {
+    return uint64_t(p[0]) | (uint64_t(p[1]) << 8) | (uint64_t(p[2]) << 16) | (uint64_t(p[3]) << 24) |
+           (uint64_t(p[4]) << 32) | (uint64_t(p[5]) << 40) | (uint64_t(p[6]) << 48) | (uint64_t(p[7]) << 56);
+}
+
+static inline void StoreLE64(uint8_t* p, uint64_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+    p[4] = static_cast<uint8_t>(v >> 32);
+    p[5] = static_cast<uint8_t>(v >> 40);
+    p[6] = static_cast<uint8_t>(v >> 48);
+    p[7] = static_cast<uint8_t>(v >> 56);
+}
+
+// Swap the bits selected by mask in a with the bits shift positions higher in b
+static inline void SwapBits(uint64_t& a, uint64_t& b, int shift, uint64_t mask) {
+    uint64_t t = ((a >> shift) ^ b) & mask;
+    b ^= t;
+    a ^= t << shift;
+}
+
+// 64 bytes <-> 8 bit planes. Word w holds bytes 8w..8w+7; after the 8x8 bit transpose
+// inside each word, byte b of word w holds bit b of those bytes, and the 8x8 byte
+// transpose across words gathers them into plane b. Both steps are involutions.
+static inline uint64_t Transpose8x8(uint64_t x) {
+    uint64_t t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+static inline void TransposeBits(uint64_t* q) {
+    for (int w = 0; w < 8; ++w) q[w] = Transpose8x8(q[w]);
+}
+
+static inline void TransposeBytes(uint64_t* q) {
+    for (int w = 0; w < 4; ++w) SwapBits(q[w], q[w + 4], 32, 0x00000000ffffffffULL);
+    for (int w = 0; w < 8; w += 4) {
+        SwapBits(q[w], q[w + 2], 16, 0x0000ffff0000ffffULL);
+        SwapBits(q[w + 1], q[w + 3], 16, 0x0000ffff0000ffffULL);
+    }
+    for (int w = 0; w < 8; w += 2) SwapBits(q[w], q[w + 1], 8, 0x00ff00ff00ff00ffULL);
+}
+
+// Exchanges the bit-index fields (block) and (row) of every plane, converting between
+// the load order 16*block + 4*col + row and the working order 16*row + 4*col + block
+static constexpr uint64_t IndexSwapMask(int lowBit, int highBit) {
+    uint64_t m = 0;
+    for (int p = 0; p < 64; ++p) {
+        if (((p >> lowBit) & 1) && !((p >> highBit) & 1)) m |= uint64_t(1) << p;
+    }
+    return m;
+}
+
+static inline void SwapRowAndBlock(uint64_t* q) {
+    constexpr uint64_t m0 = IndexSwapMask(0, 4);
+    constexpr uint64_t m1 = IndexSwapMask(1, 5);
+    for (int b = 0; b < 8; ++b) {
+        uint64_t x = q[b];
+        uint64_t t = ((x >> 15) ^ x) & m0;
+        x ^= t ^ (t << 15);
+        t = ((x >> 30) ^ x) & m1;
+        x ^= t ^ (t << 30);
+        q[b] = x;
+    }
+}
+
+// Four consecutive blocks <-> planes
+static inline void Bitslice(const uint8_t* blocks, uint64_t* q) {
+    for (int w = 0; w < 8; ++w) q[w] = LoadLE64(blocks + 8 * w);
+    TransposeBits(q);
+    TransposeBytes(q);
+    SwapRowAndBlock(q);
+}
+
+static inline void Unbitslice(uint64_t* q, uint8_t* blocks) {
+    SwapRowAndBlock(q);
+    TransposeBytes(q);
+    TransposeBits(q);
+    for (int w = 0; w < 8; ++w) StoreLE64(blocks + 8 * w, q[w]);
+}
+
+// Round keys are the same for all four blocks, so each key byte's bit is spread over a
+// nibble instead of running the full transpose. The S-box constant is folded in as well:
+// encryption adds 0x63 after every SubBytes (keys 1..Rounds), decryption removes it
+// before every InvSubBytes (keys 0..Rounds-1).
+static inline uint64_t SpreadKeyPlane(uint64_t bits) {
+    // Key byte index (4*col + row) -> bit nibble 4*(4*col + row), replicated per block
+    uint64_t x = bits & 0xffff;
+    x = (x | (x << 24)) & 0x000000ff000000ffULL;
+    x = (x | (x << 12)) & 0x000f000f000f000fULL;
+    x = (x | (x << 6)) & 0x0303030303030303ULL;
+    x = (x | (x << 3)) & 0x1111111111111111ULL;
+    x *= 0x0f;
+
+    // Exchange the (col) and (row) index fields: 16*col + 4*row -> 16*row + 4*col
+    constexpr uint64_t m0 = IndexSwapMask(2, 4);
+    constexpr uint64_t m1 = IndexSwapMask(3, 5);
+    uint64_t t = ((x >> 12) ^ x) & m0;
+    x ^= t ^ (t << 12);
+    t = ((x >> 24) ^ x) & m1;
+    x ^= t ^ (t << 24);
+    return x;
+}
+
+template <int Rounds>
+static void SliceKeys(const uint8_t* roundKeys, bool decrypt, uint64_t (*sk)[8]) {
+    for (int round = 0; round <= Rounds; ++round) {
+        // Byte b of w[h] holds bit b of key bytes 8h..8h+7
+        uint64_t w[2] = {Transpose8x8(LoadLE64(roundKeys + 16 * round)), Transpose8x8(LoadLE64(roundKeys + 16 * round + 8))};
+
+        bool fold = decrypt ? (round < Rounds) : (round > 0);
+        for (int b = 0; b < 8; ++b) {
+            uint64_t bits = ((w[0] >> (8 * b)) & 0xff) | (((w[1] >> (8 * b)) & 0xff) << 8);
+            if (fold && ((0x63 >> b) & 1)) bits = ~bits;
+            sk[round][b] = SpreadKeyPlane(bits);
+        }
+    }
+}
+
+static inline void AddRoundKeyBS(uint64_t* q, const uint64_t* k) {
+    for (int b = 0; b < 8; ++b) q[b] ^= k[b];
+}
+
+template <int Rounds>
+static void EncryptSlices(const uint64_t (*sk)[8], uint64_t* q) {
+    AddRoundKeyBS(q, sk[0]);
+    for (int round = 1; round < Rounds; ++round) {
+        SBoxCircuit(q);
+        for (int b = 0; b < 8; ++b) q[b] = ShiftRowsPlane(q[b]);
+        MixColumnsBS(q);
+        AddRoundKeyBS(q, sk[round]);
+    }
+    SBoxCircuit(q);
+    for (int b = 0; b < 8; ++b) q[b] = ShiftRowsPlane(q[b]);
+    AddRoundKeyBS(q, sk[Rounds]);
+}
+
+template <int Rounds>
+void EncryptBlocksBS(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks) {
+    uint64_t sk[Rounds + 1][8];
+    SliceKeys<Rounds>(roundKeys, false, sk);
+
+    uint64_t q[8];
+    size_t i = 0;
+    for (; i + BS_BLOCKS <= numBlocks; i += BS_BLOCKS) {
+        Bitslice(input + 16 * i, q);
+        EncryptSlices<Rounds>(sk, q);
+        Unbitslice(q, output + 16 * i);
+    }
+
+    if (i < numBlocks) {
+        uint8_t buf[16 * BS_BLOCKS] = {};
+        size_t tailBytes = (numBlocks - i) * 16;
+        std::memcpy(buf, input + 16 * i, tailBytes);
+        Bitslice(buf, q);
+        EncryptSlices<Rounds>(sk, q);
+        Unbitslice(q, buf);
+        std::memcpy(output + 16 * i, buf, tailBytes);
+    }
+}
+
+template <int Rounds>
+void EncryptBlockBS(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output) {
+    EncryptBlocksBS<Rounds>(roundKeys, input, output, 1);
+}
+
+// Equivalent inverse cipher on the InvertKeySchedule output, like DecryptBlockT
+template <int Rounds>
+void DecryptBlockBS(const uint8_t* decKeys, const uint8_t* input, uint8_t* output) {
+    uint64_t sk[Rounds + 1][8];
+    SliceKeys<Rounds>(decKeys, true, sk);
+
+    uint8_t buf[16 * BS_BLOCKS] = {};
+    std::memcpy(buf, input, 16);
+    uint64_t q[8];
+    Bitslice(buf, q);
+
+    AddRoundKeyBS(q, sk[0]);
+    for (int round = 1; round < Rounds; ++round) {
+        InvSBoxCircuit(q);
+        for (int b = 0; b < 8; ++b) q[b] = InvShiftRowsPlane(q[b]);
+        InvMixColumnsBS(q);
+        AddRoundKeyBS(q, sk[round]);
+    }
+    InvSBoxCircuit(q);
+    for (int b = 0; b < 8; ++b) q[b] = InvShiftRowsPlane(q[b]);
+    AddRoundKeyBS(q, sk[Rounds]);
+
+    Unbitslice(q, buf);
+    std::memcpy(output, buf, 16);
+}
+
+template void EncryptBlockBS<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockBS<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockBS<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockBS<14>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlocksBS<7>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksBS<10>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksBS<12>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksBS<14>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void DecryptBlockBS<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockBS<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockBS<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockBS<14>(const uint8_t*, const uint8_t*, uint8_t*);
+
+} // namespace AESCore
@@ -4,104 +4,155 @@
 
 namespace AESCore {
 
-// Constants
-static const uint8_t sbox[256] = {
-    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
-    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
-    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
-    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
-    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
-    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
-    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
-    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
-    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
-    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
-    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
-    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
-    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
-    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
-    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
-    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+// GF(2^8) multiplication by x modulo the AES polynomial x^8 + x^4 + x^3 + x + 1
+constexpr uint8_t xtime(uint8_t x) {
+    return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+constexpr uint8_t rotl8(uint8_t x, int n) {
+    return static_cast<uint8_t>((x << n) | (x >> (8 - n)));
+}
+
+// Constants, generated at compile time: the S-box is the multiplicative inverse in
+// GF(2^8) (via exp/log tables over the generator 0x03) followed by the AES affine map.
+struct SBoxTables {
+    uint8_t sbox[256];
+    uint8_t rsbox[256];
 };
 
-static const uint8_t rsbox[256] = {
-    0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
-    0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
-    0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
-    0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
-    0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
-    0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
-    0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
-    0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
-    0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
-    0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
-    0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
-    0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
-    0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
-    0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
-    0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
-    0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
+constexpr SBoxTables MakeSBoxes() {
+    SBoxTables t{};
+    uint8_t exp[256] = {};
+    uint8_t log[256] = {};
+    uint8_t x = 1;
+    for (int i = 0; i < 255; ++i) {
+        exp[i] = x;
+        log[x] = static_cast<uint8_t>(i);
+        x = static_cast<uint8_t>(x ^ xtime(x));
+    }
+    for (int i = 0; i < 256; ++i) {
+        uint8_t inv = (i == 0) ? 0 : exp[(255 - log[i]) % 255];
+        uint8_t s = static_cast<uint8_t>(inv ^ rotl8(inv, 1) ^ rotl8(inv, 2) ^ rotl8(inv, 3) ^ rotl8(inv, 4) ^ 0x63);
+        t.sbox[i] = s;
+        t.rsbox[s] = static_cast<uint8_t>(i);
+    }
+    return t;
+}
+
+struct RconTable {
+    uint8_t values[11];
 };
 
-static const uint8_t Rcon[11] = {
-    0x8d, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
+constexpr RconTable MakeRcon() {
+    RconTable t{};
+    t.values[0] = 0x8d;
+    t.values[1] = 0x01;
+    for (int i = 2; i < 11; ++i) t.values[i] = xtime(t.values[i - 1]);
+    return t;
+}
+
+static constexpr SBoxTables sboxes = MakeSBoxes();
+static constexpr const uint8_t (&sbox)[256] = sboxes.sbox;
+static constexpr const uint8_t (&rsbox)[256] = sboxes.rsbox;
+
+static constexpr RconTable rconTable = MakeRcon();
+static constexpr const uint8_t (&Rcon)[11] = rconTable.values;
+
+static_assert(sbox[0x00] == 0x63 && sbox[0x53] == 0xed && sbox[0xff] == 0x16, "S-box generation");
+static_assert(rsbox[0x63] == 0x00 && rsbox[0x7c] == 0x01, "Inverse S-box generation");
+static_assert(Rcon[10] == 0x36, "Rcon generation");
+
+// T-tables: one state column of SubBytes+MixColumns (Te) or InvSubBytes+InvMixColumns (Td)
+// per input byte, packed big-endian so row 0 sits in the top byte of the word.
+// Te1..Te3 / Td1..Td3 are byte rotations of Te0 / Td0 for rows 1..3.
+// Te4 / Td4 replicate the plain (inverse) S-box for the final round, which skips MixColumns.
+struct TTables {
+    uint32_t Te0[256], Te1[256], Te2[256], Te3[256], Te4[256];
+    uint32_t Td0[256], Td1[256], Td2[256], Td3[256], Td4[256];
 };
 
-// Helper: Galois Field Multiplication
-inline uint8_t gf_mul(uint8_t a, uint8_t b) {
-    uint8_t p = 0;
-    bool hi_bit_set;
-    
-    if ((b & 1) != 0) p ^= a;
-    hi_bit_set = (a & 0x80) != 0;
-    a <<= 1;
-    if (hi_bit_set) a ^= 0x1b;
-    b >>= 1;
-
-    if ((b & 1) != 0) p ^= a;
-    hi_bit_set = (a & 0x80) != 0;
-    a <<= 1;
-    if (hi_bit_set) a ^= 0x1b;
-    b >>= 1;
-
-    if ((b & 1) != 0) p ^= a;
-    hi_bit_set = (a & 0x80) != 0;
-    a <<= 1;
-    if (hi_bit_set) a ^= 0x1b;
-    b >>= 1;
-
-    if ((b & 1) != 0) p ^= a;
-    hi_bit_set = (a & 0x80) != 0;
-    a <<= 1;
-    if (hi_bit_set) a ^= 0x1b;
-    b >>= 1;
-
-    if ((b & 1) != 0) p ^= a;
-    hi_bit_set = (a & 0x80) != 0;
-    a <<= 1;
-    if (hi_bit_set) a ^= 0x1b;
-    b >>= 1;
-
-    if ((b & 1) != 0) p ^= a;
-    hi_bit_set = (a & 0x80) != 0;
-    a <<= 1;
-    if (hi_bit_set) a ^= 0x1b;
-    b >>= 1;
-
-    if ((b & 1) != 0) p ^= a;
-    hi_bit_set = (a & 0x80) != 0;
-    a <<= 1;
-    if (hi_bit_set) a ^= 0x1b;
-    b >>= 1;
-
-    if ((b & 1) != 0) p ^= a;
-    hi_bit_set = (a & 0x80) != 0;
-    a <<= 1;
-    if (hi_bit_set) a ^= 0x1b;
-    
-    return p;
+constexpr uint32_t ror8(uint32_t w) {
+    return (w >> 8) | (w << 24);
 }
 
+constexpr TTables MakeTTables() {
+    TTables t{};
+    for (int i = 0; i < 256; ++i) {
+        uint8_t s = sbox[i];
+        uint8_t s2 = xtime(s);
+        uint8_t s3 = s2 ^ s;
+        uint32_t e = (uint32_t(s2) << 24) | (uint32_t(s) << 16) | (uint32_t(s) << 8) | s3;
+        t.Te0[i] = e;
+        t.Te1[i] = ror8(e);
+        t.Te2[i] = ror8(ror8(e));
+        t.Te3[i] = ror8(ror8(ror8(e)));
+        t.Te4[i] = uint32_t(s) * 0x01010101u;
+
+        uint8_t r = rsbox[i];
+        uint8_t r2 = xtime(r);
+        uint8_t r4 = xtime(r2);
+        uint8_t r8 = xtime(r4);
+        uint8_t r9 = r8 ^ r;
+        uint8_t rb = r8 ^ r2 ^ r;
+        uint8_t rd = r8 ^ r4 ^ r;
+        uint8_t re = r8 ^ r4 ^ r2;
+        uint32_t d = (uint32_t(re) << 24) | (uint32_t(r9) << 16) | (uint32_t(rd) << 8) | rb;
+        t.Td0[i] = d;
+        t.Td1[i] = ror8(d);
+        t.Td2[i] = ror8(ror8(d));
+        t.Td3[i] = ror8(ror8(ror8(d)));
+        t.Td4[i] = uint32_t(r) * 0x01010101u;
+    }
+    return t;
+}
+
+static constexpr TTables tables = MakeTTables();
+
+static inline uint32_t LoadWord(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static inline void StoreWord(uint8_t* p, uint32_t w) {
+    p[0] = static_cast<uint8_t>(w >> 24);
+    p[1] = static_cast<uint8_t>(w >> 16);
+    p[2] = static_cast<uint8_t>(w >> 8);
+    p[3] = static_cast<uint8_t>(w);
+}
+
+// GF(2^8) multiplication tables for the byte-wise MixColumns/InvMixColumns: one lookup
+// per coefficient instead of a shift-and-add loop.
+struct MulTables {
+    uint8_t mul2[256], mul3[256];
+    uint8_t mul9[256], mul11[256], mul13[256], mul14[256];
+};
+
+constexpr MulTables MakeMulTables() {
+    MulTables t{};
+    for (int i = 0; i < 256; ++i) {
+        uint8_t x = static_cast<uint8_t>(i);
+        uint8_t x2 = xtime(x);
+        uint8_t x4 = xtime(x2);
+        uint8_t x8 = xtime(x4);
+        t.mul2[i] = x2;
+        t.mul3[i] = x2 ^ x;
+        t.mul9[i] = x8 ^ x;
+        t.mul11[i] = x8 ^ x2 ^ x;
+        t.mul13[i] = x8 ^ x4 ^ x;
+        t.mul14[i] = x8 ^ x4 ^ x2;
+    }
+    return t;
+}
+
+static constexpr MulTables mulTables = MakeMulTables();
+static constexpr const uint8_t (&mul2)[256] = mulTables.mul2;
+static constexpr const uint8_t (&mul3)[256] = mulTables.mul3;
+static constexpr const uint8_t (&mul9)[256] = mulTables.mul9;
+static constexpr const uint8_t (&mul11)[256] = mulTables.mul11;
+static constexpr const uint8_t (&mul13)[256] = mulTables.mul13;
+static constexpr const uint8_t (&mul14)[256] = mulTables.mul14;
+
+static_assert(mul2[0x80] == 0x1b && mul3[0xff] == 0x1a && mul14[0x01] == 0x0e, "GF(2^8) multiplication tables");
+
 void SubBytes(State& state) {
     state[0] = sbox[state[0]];
     state[1] = sbox[state[1]];
@@ -168,28 +219,28 @@ void MixColumns(State& state) {
     uint8_t tmp[16];
     
     // Column 0
-    tmp[0] = gf_mul(0x02, state[0]) ^ gf_mul(0x03, state[1]) ^ state[2] ^ state[3];
-    tmp[1] = state[0] ^ gf_mul(0x02, state[1]) ^ gf_mul(0x03, state[2]) ^ state[3];
-    tmp[2] = state[0] ^ state[1] ^ gf_mul(0x02, state[2]) ^ gf_mul(0x03, state[3]);
-    tmp[3] = gf_mul(0x03, state[0]) ^ state[1] ^ state[2] ^ gf_mul(0x02, state[3]);
+    tmp[0] = mul2[state[0]] ^ mul3[state[1]] ^ state[2] ^ state[3];
+    tmp[1] = state[0] ^ mul2[state[1]] ^ mul3[state[2]] ^ state[3];
+    tmp[2] = state[0] ^ state[1] ^ mul2[state[2]] ^ mul3[state[3]];
+    tmp[3] = mul3[state[0]] ^ state[1] ^ state[2] ^ mul2[state[3]];
 
     // Column 1
-    tmp[4] = gf_mul(0x02, state[4]) ^ gf_mul(0x03, state[5]) ^ state[6] ^ state[7];
-    tmp[5] = state[4] ^ gf_mul(0x02, state[5]) ^ gf_mul(0x03, state[6]) ^ state[7];
-    tmp[6] = state[4] ^ state[5] ^ gf_mul(0x02, state[6]) ^ gf_mul(0x03, state[7]);
-    tmp[7] = gf_mul(0x03, state[4]) ^ state[5] ^ state[6] ^ gf_mul(0x02, state[7]);
+    tmp[4] = mul2[state[4]] ^ mul3[state[5]] ^ state[6] ^ state[7];
+    tmp[5] = state[4] ^ mul2[state[5]] ^ mul3[state[6]] ^ state[7];
+    tmp[6] = state[4] ^ state[5] ^ mul2[state[6]] ^ mul3[state[7]];
+    tmp[7] = mul3[state[4]] ^ state[5] ^ state[6] ^ mul2[state[7]];
 
     // Column 2
-    tmp[8] = gf_mul(0x02, state[8]) ^ gf_mul(0x03, state[9]) ^ state[10] ^ state[11];
-    tmp[9] = state[8] ^ gf_mul(0x02, state[9]) ^ gf_mul(0x03, state[10]) ^ state[11];
-    tmp[10]= state[8] ^ state[9] ^ gf_mul(0x02, state[10]) ^ gf_mul(0x03, state[11]);
-    tmp[11]= gf_mul(0x03, state[8]) ^ state[9] ^ state[10] ^ gf_mul(0x02, state[11]);
+    tmp[8] = mul2[state[8]] ^ mul3[state[9]] ^ state[10] ^ state[11];
+    tmp[9] = state[8] ^ mul2[state[9]] ^ mul3[state[10]] ^ state[11];
+    tmp[10]= state[8] ^ state[9] ^ mul2[state[10]] ^ mul3[state[11]];
+    tmp[11]= mul3[state[8]] ^ state[9] ^ state[10] ^ mul2[state[11]];
 
     // Column 3
-    tmp[12]= gf_mul(0x02, state[12]) ^ gf_mul(0x03, state[13]) ^ state[14] ^ state[15];
-    tmp[13]= state[12] ^ gf_mul(0x02, state[13]) ^ gf_mul(0x03, state[14]) ^ state[15];
-    tmp[14]= state[12] ^ state[13] ^ gf_mul(0x02, state[14]) ^ gf_mul(0x03, state[15]);
-    tmp[15]= gf_mul(0x03, state[12]) ^ state[13] ^ state[14] ^ gf_mul(0x02, state[15]);
+    tmp[12]= mul2[state[12]] ^ mul3[state[13]] ^ state[14] ^ state[15];
+    tmp[13]= state[12] ^ mul2[state[13]] ^ mul3[state[14]] ^ state[15];
+    tmp[14]= state[12] ^ state[13] ^ mul2[state[14]] ^ mul3[state[15]];
+    tmp[15]= mul3[state[12]] ^ state[13] ^ state[14] ^ mul2[state[15]];
 
     std::memcpy(state.data(), tmp, 16);
 }
@@ -198,28 +249,28 @@ void InvMixColumns(State& state) {
     uint8_t tmp[16];
     
     // Column 0
-    tmp[0]   = gf_mul(0x0e, state[0]) ^ gf_mul(0x0b, state[1]) ^ gf_mul(0x0d, state[2]) ^ gf_mul(0x09, state[3]);
-    tmp[1]   = gf_mul(0x09, state[0]) ^ gf_mul(0x0e, state[1]) ^ gf_mul(0x0b, state[2]) ^ gf_mul(0x0d, state[3]);
-    tmp[2]   = gf_mul(0x0d, state[0]) ^ gf_mul(0x09, state[1]) ^ gf_mul(0x0e, state[2]) ^ gf_mul(0x0b, state[3]);
-    tmp[3]   = gf_mul(0x0b, state[0]) ^ gf_mul(0x0d, state[1]) ^ gf_mul(0x09, state[2]) ^ gf_mul(0x0e, state[3]);
+    tmp[0]   = mul14[state[0]] ^ mul11[state[1]] ^ mul13[state[2]] ^ mul9[state[3]];
+    tmp[1]   = mul9[state[0]] ^ mul14[state[1]] ^ mul11[state[2]] ^ mul13[state[3]];
+    tmp[2]   = mul13[state[0]] ^ mul9[state[1]] ^ mul14[state[2]] ^ mul11[state[3]];
+    tmp[3]   = mul11[state[0]] ^ mul13[state[1]] ^ mul9[state[2]] ^ mul14[state[3]];
 
     // Column 1
-    tmp[4]   = gf_mul(0x0e, state[4]) ^ gf_mul(0x0b, state[5]) ^ gf_mul(0x0d, state[6]) ^ gf_mul(0x09, state[7]);
-    tmp[5]   = gf_mul(0x09, state[4]) ^ gf_mul(0x0e, state[5]) ^ gf_mul(0x0b, state[6]) ^ gf_mul(0x0d, state[7]);
-    tmp[6]   = gf_mul(0x0d, state[4]) ^ gf_mul(0x09, state[5]) ^ gf_mul(0x0e, state[6]) ^ gf_mul(0x0b, state[7]);
-    tmp[7]   = gf_mul(0x0b, state[4]) ^ gf_mul(0x0d, state[5]) ^ gf_mul(0x09, state[6]) ^ gf_mul(0x0e, state[7]);
+    tmp[4]   = mul14[state[4]] ^ mul11[state[5]] ^ mul13[state[6]] ^ mul9[state[7]];
+    tmp[5]   = mul9[state[4]] ^ mul14[state[5]] ^ mul11[state[6]] ^ mul13[state[7]];
+    tmp[6]   = mul13[state[4]] ^ mul9[state[5]] ^ mul14[state[6]] ^ mul11[state[7]];
+    tmp[7]   = mul11[state[4]] ^ mul13[state[5]] ^ mul9[state[6]] ^ mul14[state[7]];
 
     // Column 2
-    tmp[8]   = gf_mul(0x0e, state[8]) ^ gf_mul(0x0b, state[9]) ^ gf_mul(0x0d, state[10]) ^ gf_mul(0x09, state[11]);
-    tmp[9]   = gf_mul(0x09, state[8]) ^ gf_mul(0x0e, state[9]) ^ gf_mul(0x0b, state[10]) ^ gf_mul(0x0d, state[11]);
-    tmp[10]  = gf_mul(0x0d, state[8]) ^ gf_mul(0x09, state[9]) ^ gf_mul(0x0e, state[10]) ^ gf_mul(0x0b, state[11]);
-    tmp[11]  = gf_mul(0x0b, state[8]) ^ gf_mul(0x0d, state[9]) ^ gf_mul(0x09, state[10]) ^ gf_mul(0x0e, state[11]);
+    tmp[8]   = mul14[state[8]] ^ mul11[state[9]] ^ mul13[state[10]] ^ mul9[state[11]];
+    tmp[9]   = mul9[state[8]] ^ mul14[state[9]] ^ mul11[state[10]] ^ mul13[state[11]];
+    tmp[10]  = mul13[state[8]] ^ mul9[state[9]] ^ mul14[state[10]] ^ mul11[state[11]];
+    tmp[11]  = mul11[state[8]] ^ mul13[state[9]] ^ mul9[state[10]] ^ mul14[state[11]];
 
     // Column 3
-    tmp[12]  = gf_mul(0x0e, state[12]) ^ gf_mul(0x0b, state[13]) ^ gf_mul(0x0d, state[14]) ^ gf_mul(0x09, state[15]);
-    tmp[13]  = gf_mul(0x09, state[12]) ^ gf_mul(0x0e, state[13]) ^ gf_mul(0x0b, state[14]) ^ gf_mul(0x0d, state[15]);
-    tmp[14]  = gf_mul(0x0d, state[12]) ^ gf_mul(0x09, state[13]) ^ gf_mul(0x0e, state[14]) ^ gf_mul(0x0b, state[15]);
-    tmp[15]  = gf_mul(0x0b, state[12]) ^ gf_mul(0x0d, state[13]) ^ gf_mul(0x09, state[14]) ^ gf_mul(0x0e, state[15]);
+    tmp[12]  = mul14[state[12]] ^ mul11[state[13]] ^ mul13[state[14]] ^ mul9[state[15]];
+    tmp[13]  = mul9[state[12]] ^ mul14[state[13]] ^ mul11[state[14]] ^ mul13[state[15]];
+    tmp[14]  = mul13[state[12]] ^ mul9[state[13]] ^ mul14[state[14]] ^ mul11[state[15]];
+    tmp[15]  = mul11[state[12]] ^ mul13[state[13]] ^ mul9[state[14]] ^ mul14[state[15]];
 
     std::memcpy(state.data(), tmp, 16);
 }
@@ -243,41 +294,264 @@ void AddRoundKey(State& state, const uint8_t* roundKey) {
     state[15] ^= roundKey[15];
 }
 
-std::vector<uint8_t> ExpandKey(const std::vector<uint8_t>& key, int rounds) {
-    if (key.size() != 16) throw std::invalid_argument("S-AES requires a 128-bit key.");
-    
-    int expandedSize = 16 * (rounds + 1);
-    std::vector<uint8_t> expandedKey(expandedSize);
-    std::memcpy(expandedKey.data(), key.data(), 16);
-
-    int bytesGenerated = 16;
-    int rconIteration = 1;
-    uint8_t temp[4];
+void ExpandKey(const uint8_t* key, size_t keyLength, int rounds, uint8_t* expandedKey) {
+    if (rounds != 7 && rounds != 10 && rounds != 12 && rounds != 14) {
+        throw std::invalid_argument("Unsupported AES round count.");
+    }
+    if (keyLength != KeySizeFor(rounds)) {
+        if (rounds == 7) throw std::invalid_argument("S-AES requires a 128-bit key.");
+        throw std::invalid_argument("Key length does not match the AES round count.");
+    }
 
-    while (bytesGenerated < expandedSize) {
-        temp[0] = expandedKey[bytesGenerated - 4];
-        temp[1] = expandedKey[bytesGenerated - 3];
-        temp[2] = expandedKey[bytesGenerated - 2];
-        temp[3] = expandedKey[bytesGenerated - 1];
+    const int nk = static_cast<int>(keyLength / 4);
+    const int totalWords = 4 * (rounds + 1);
+    std::memcpy(expandedKey, key, keyLength);
 
-        if (bytesGenerated % 16 == 0) {
+    uint8_t temp[4];
+    for (int i = nk; i < totalWords; ++i) {
+        const uint8_t* prev = expandedKey + ((i - 1) * 4);
+        temp[0] = prev[0];
+        temp[1] = prev[1];
+        temp[2] = prev[2];
+        temp[3] = prev[3];
+
+        if (i % nk == 0) {
             uint8_t t = temp[0];
-            temp[0] = sbox[temp[1]] ^ Rcon[rconIteration++];
+            temp[0] = sbox[temp[1]] ^ Rcon[i / nk];
             temp[1] = sbox[temp[2]];
             temp[2] = sbox[temp[3]];
             temp[3] = sbox[t];
+        } else if (nk > 6 && i % nk == 4) {
+            // AES-256 applies an extra SubWord halfway through each key block
+            temp[0] = sbox[temp[0]];
+            temp[1] = sbox[temp[1]];
+            temp[2] = sbox[temp[2]];
+            temp[3] = sbox[temp[3]];
         }
 
-        expandedKey[bytesGenerated] = expandedKey[bytesGenerated - 16] ^ temp[0];
-        bytesGenerated++;
-        expandedKey[bytesGenerated] = expandedKey[bytesGenerated - 16] ^ temp[1];
-        bytesGenerated++;
-        expandedKey[bytesGenerated] = expandedKey[bytesGenerated - 16] ^ temp[2];
-        bytesGenerated++;
-        expandedKey[bytesGenerated] = expandedKey[bytesGenerated - 16] ^ temp[3];
-        bytesGenerated++;
+        const uint8_t* back = expandedKey + ((i - nk) * 4);
+        uint8_t* word = expandedKey + (i * 4);
+        word[0] = back[0] ^ temp[0];
+        word[1] = back[1] ^ temp[1];
+        word[2] = back[2] ^ temp[2];
+        word[3] = back[3] ^ temp[3];
     }
+}
+
+std::vector<uint8_t> ExpandKey(const std::vector<uint8_t>& key, int rounds) {
+    std::vector<uint8_t> expandedKey(16 * (rounds + 1));
+    ExpandKey(key.data(), key.size(), rounds, expandedKey.data());
     return expandedKey;
 }
 
-} // namespace AESCore
\ No newline at end of file
+void InvertKeySchedule(const uint8_t* expandedKey, int rounds, uint8_t* decKey) {
+    // Round keys are used in reverse order; the inner ones are passed through
+    // InvMixColumns so decryption can apply AddRoundKey after InvMixColumns.
+    std::memcpy(decKey, expandedKey + (rounds * 16), 16);
+    for (int round = 1; round < rounds; ++round) {
+        State roundKey;
+        std::memcpy(roundKey.data(), expandedKey + ((rounds - round) * 16), 16);
+        InvMixColumns(roundKey);
+        std::memcpy(decKey + (round * 16), roundKey.data(), 16);
+    }
+    std::memcpy(decKey + (rounds * 16), expandedKey, 16);
+}
+
+std::vector<uint8_t> InvertKeySchedule(const std::vector<uint8_t>& expandedKey, int rounds) {
+    std::vector<uint8_t> decKey(expandedKey.size());
+    InvertKeySchedule(expandedKey.data(), rounds, decKey.data());
+    return decKey;
+}
+
+template <int Rounds>
+void EncryptBlockRef(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output) {
+    State state;
+    std::memcpy(state.data(), input, 16);
+
+    AddRoundKey(state, roundKeys);
+
+    Unroll<1, Rounds>([&](auto round) {
+        SubBytes(state);
+        ShiftRows(state);
+        MixColumns(state);
+        AddRoundKey(state, roundKeys + (round * 16));
+    });
+
+    SubBytes(state);
+    ShiftRows(state);
+    AddRoundKey(state, roundKeys + (Rounds * 16));
+
+    std::memcpy(output, state.data(), 16);
+}
+
+template <int Rounds>
+void EncryptBlocksRef(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks) {
+    for (size_t i = 0; i < numBlocks; ++i) {
+        EncryptBlockRef<Rounds>(roundKeys, input + (i * 16), output + (i * 16));
+    }
+}
+
+template <int Rounds>
+void DecryptBlockRef(const uint8_t* decKeys, const uint8_t* input, uint8_t* output) {
+    State state;
+    std::memcpy(state.data(), input, 16);
+
+    AddRoundKey(state, decKeys);
+
+    Unroll<1, Rounds>([&](auto round) {
+        InvSubBytes(state);
+        InvShiftRows(state);
+        InvMixColumns(state);
+        AddRoundKey(state, decKeys + (round * 16));
+    });
+
+    InvSubBytes(state);
+    InvShiftRows(state);
+    AddRoundKey(state, decKeys + (Rounds * 16));
+
+    std::memcpy(output, state.data(), 16);
+}
+
+// Round keys as big-endian words, loaded once per call
+template <int Rounds>
+struct RoundKeyWords {
+    uint32_t w[4 * (Rounds + 1)];
+
+    explicit RoundKeyWords(const uint8_t* roundKeys) {
+        for (int i = 0; i < 4 * (Rounds + 1); ++i) w[i] = LoadWord(roundKeys + (i * 4));
+    }
+};
+
+static inline void LoadStateT(uint32_t s[4], const uint8_t* input, const uint32_t* rk) {
+    s[0] = LoadWord(input)      ^ rk[0];
+    s[1] = LoadWord(input + 4)  ^ rk[1];
+    s[2] = LoadWord(input + 8)  ^ rk[2];
+    s[3] = LoadWord(input + 12) ^ rk[3];
+}
+
+// One full T-table round on a state held as four big-endian column words
+static inline void EncRoundT(uint32_t s[4], const uint32_t* rk) {
+    uint32_t t0 = tables.Te0[s[0] >> 24] ^ tables.Te1[(s[1] >> 16) & 0xff] ^ tables.Te2[(s[2] >> 8) & 0xff] ^ tables.Te3[s[3] & 0xff] ^ rk[0];
+    uint32_t t1 = tables.Te0[s[1] >> 24] ^ tables.Te1[(s[2] >> 16) & 0xff] ^ tables.Te2[(s[3] >> 8) & 0xff] ^ tables.Te3[s[0] & 0xff] ^ rk[1];
+    uint32_t t2 = tables.Te0[s[2] >> 24] ^ tables.Te1[(s[3] >> 16) & 0xff] ^ tables.Te2[(s[0] >> 8) & 0xff] ^ tables.Te3[s[1] & 0xff] ^ rk[2];
+    uint32_t t3 = tables.Te0[s[3] >> 24] ^ tables.Te1[(s[0] >> 16) & 0xff] ^ tables.Te2[(s[1] >> 8) & 0xff] ^ tables.Te3[s[2] & 0xff] ^ rk[3];
+    s[0] = t0; s[1] = t1; s[2] = t2; s[3] = t3;
+}
+
+// Final round: SubBytes + ShiftRows + AddRoundKey, written straight to the output block
+static inline void EncFinalT(const uint32_t s[4], const uint32_t* rk, uint8_t* output) {
+    StoreWord(output, (tables.Te4[s[0] >> 24] & 0xff000000) ^ (tables.Te4[(s[1] >> 16) & 0xff] & 0x00ff0000) ^
+                      (tables.Te4[(s[2] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Te4[s[3] & 0xff] & 0x000000ff) ^ rk[0]);
+    StoreWord(output + 4, (tables.Te4[s[1] >> 24] & 0xff000000) ^ (tables.Te4[(s[2] >> 16) & 0xff] & 0x00ff0000) ^
+                          (tables.Te4[(s[3] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Te4[s[0] & 0xff] & 0x000000ff) ^ rk[1]);
+    StoreWord(output + 8, (tables.Te4[s[2] >> 24] & 0xff000000) ^ (tables.Te4[(s[3] >> 16) & 0xff] & 0x00ff0000) ^
+                          (tables.Te4[(s[0] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Te4[s[1] & 0xff] & 0x000000ff) ^ rk[2]);
+    StoreWord(output + 12, (tables.Te4[s[3] >> 24] & 0xff000000) ^ (tables.Te4[(s[0] >> 16) & 0xff] & 0x00ff0000) ^
+                           (tables.Te4[(s[1] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Te4[s[2] & 0xff] & 0x000000ff) ^ rk[3]);
+}
+
+static inline void DecRoundT(uint32_t s[4], const uint32_t* rk) {
+    uint32_t t0 = tables.Td0[s[0] >> 24] ^ tables.Td1[(s[3] >> 16) & 0xff] ^ tables.Td2[(s[2] >> 8) & 0xff] ^ tables.Td3[s[1] & 0xff] ^ rk[0];
+    uint32_t t1 = tables.Td0[s[1] >> 24] ^ tables.Td1[(s[0] >> 16) & 0xff] ^ tables.Td2[(s[3] >> 8) & 0xff] ^ tables.Td3[s[2] & 0xff] ^ rk[1];
+    uint32_t t2 = tables.Td0[s[2] >> 24] ^ tables.Td1[(s[1] >> 16) & 0xff] ^ tables.Td2[(s[0] >> 8) & 0xff] ^ tables.Td3[s[3] & 0xff] ^ rk[2];
+    uint32_t t3 = tables.Td0[s[3] >> 24] ^ tables.Td1[(s[2] >> 16) & 0xff] ^ tables.Td2[(s[1] >> 8) & 0xff] ^ tables.Td3[s[0] & 0xff] ^ rk[3];
+    s[0] = t0; s[1] = t1; s[2] = t2; s[3] = t3;
+}
+
+// Final round: InvShiftRows + InvSubBytes + AddRoundKey
+static inline void DecFinalT(const uint32_t s[4], const uint32_t* rk, uint8_t* output) {
+    StoreWord(output, (tables.Td4[s[0] >> 24] & 0xff000000) ^ (tables.Td4[(s[3] >> 16) & 0xff] & 0x00ff0000) ^
+                      (tables.Td4[(s[2] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Td4[s[1] & 0xff] & 0x000000ff) ^ rk[0]);
+    StoreWord(output + 4, (tables.Td4[s[1] >> 24] & 0xff000000) ^ (tables.Td4[(s[0] >> 16) & 0xff] & 0x00ff0000) ^
+                          (tables.Td4[(s[3] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Td4[s[2] & 0xff] & 0x000000ff) ^ rk[1]);
+    StoreWord(output + 8, (tables.Td4[s[2] >> 24] & 0xff000000) ^ (tables.Td4[(s[1] >> 16) & 0xff] & 0x00ff0000) ^
+                          (tables.Td4[(s[0] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Td4[s[3] & 0xff] & 0x000000ff) ^ rk[2]);
+    StoreWord(output + 12, (tables.Td4[s[3] >> 24] & 0xff000000) ^ (tables.Td4[(s[2] >> 16) & 0xff] & 0x00ff0000) ^
+                           (tables.Td4[(s[1] >> 8) & 0xff] & 0x0000ff00) ^ (tables.Td4[s[0] & 0xff] & 0x000000ff) ^ rk[3]);
+}
+
+template <int Rounds>
+void EncryptBlockT(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output) {
+    EncryptBlocksT<Rounds>(roundKeys, input, output, 1);
+}
+
+template <int Rounds>
+void EncryptBlocksT(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks) {
+    const RoundKeyWords<Rounds> keys(roundKeys);
+    const uint32_t* rkLast = keys.w + (Rounds * 4);
+    size_t i = 0;
+
+    // Four independent states per round so their table loads overlap
+    for (; i + 4 <= numBlocks; i += 4) {
+        const uint8_t* in = input + (i * 16);
+        uint8_t* out = output + (i * 16);
+        uint32_t s0[4], s1[4], s2[4], s3[4];
+        LoadStateT(s0, in, keys.w);
+        LoadStateT(s1, in + 16, keys.w);
+        LoadStateT(s2, in + 32, keys.w);
+        LoadStateT(s3, in + 48, keys.w);
+
+        Unroll<1, Rounds>([&](auto round) {
+            const uint32_t* rk = keys.w + (round * 4);
+            EncRoundT(s0, rk);
+            EncRoundT(s1, rk);
+            EncRoundT(s2, rk);
+            EncRoundT(s3, rk);
+        });
+
+        EncFinalT(s0, rkLast, out);
+        EncFinalT(s1, rkLast, out + 16);
+        EncFinalT(s2, rkLast, out + 32);
+        EncFinalT(s3, rkLast, out + 48);
+    }
+
+    for (; i < numBlocks; ++i) {
+        uint32_t state[4];
+        LoadStateT(state, input + (i * 16), keys.w);
+        Unroll<1, Rounds>([&](auto round) {
+            EncRoundT(state, keys.w + (round * 4));
+        });
+        EncFinalT(state, rkLast, output + (i * 16));
+    }
+}
+
+template <int Rounds>
+void DecryptBlockT(const uint8_t* decKeys, const uint8_t* input, uint8_t* output) {
+    const RoundKeyWords<Rounds> keys(decKeys);
+    uint32_t state[4];
+    LoadStateT(state, input, keys.w);
+
+    Unroll<1, Rounds>([&](auto round) {
+        DecRoundT(state, keys.w + (round * 4));
+    });
+
+    DecFinalT(state, keys.w + (Rounds * 4), output);
+}
+
+template void EncryptBlockRef<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockRef<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockRef<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockRef<14>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlocksRef<7>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksRef<10>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksRef<12>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksRef<14>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void DecryptBlockRef<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockRef<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockRef<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockRef<14>(const uint8_t*, const uint8_t*, uint8_t*);
+
+template void EncryptBlockT<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockT<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockT<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockT<14>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlocksT<7>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksT<10>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksT<12>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksT<14>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void DecryptBlockT<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockT<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockT<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockT<14>(const uint8_t*, const uint8_t*, uint8_t*);
+
+} // namespace AESCore
@@ -0,0 +1,219 @@
+#include "aes_core.hpp"
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define AESNI_AVAILABLE 1
+#include <immintrin.h>
+#endif
+
+namespace AESCore {
+
+#ifdef AESNI_AVAILABLE
+
+// Enable AES-NI code generation for this section only; the rest of the tree builds
+// without -maes. A pragma is used instead of a per-function target attribute because
+// GCC ignores the attribute on templates declared earlier without it (aes_core.hpp).
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("aes,sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("aes,sse2")
+#endif
+
+// Round keys are consumed in the byte order produced by ExpandKey, so the hardware
+// path shares its schedule with the software engines. The decryption schedule from
+// InvertKeySchedule is exactly what AESIMC would produce for AESDEC.
+// Round loops use plain for-loops over the compile-time bound, which the compiler
+// unrolls, rather than Unroll: lambda bodies do not reliably inherit the target.
+template <int Rounds>
+void EncryptBlockNI(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output) {
+    const __m128i* rk = reinterpret_cast<const __m128i*>(roundKeys);
+    __m128i state = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input)), _mm_loadu_si128(rk));
+
+    for (int round = 1; round < Rounds; ++round) {
+        state = _mm_aesenc_si128(state, _mm_loadu_si128(rk + round));
+    }
+    state = _mm_aesenclast_si128(state, _mm_loadu_si128(rk + Rounds));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), state);
+}
+
+// Eight blocks in flight: AESENC has a multi-cycle latency but single-cycle
+// throughput, so independent blocks fill the pipeline.
+template <int Rounds>
+void EncryptBlocksNI(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks) {
+    const __m128i* rk = reinterpret_cast<const __m128i*>(roundKeys);
+    const __m128i* in = reinterpret_cast<const __m128i*>(input);
+    __m128i* out = reinterpret_cast<__m128i*>(output);
+    size_t i = 0;
+
+    for (; i + 8 <= numBlocks; i += 8) {
+        __m128i key = _mm_loadu_si128(rk);
+        __m128i b0 = _mm_xor_si128(_mm_loadu_si128(in + i),     key);
+        __m128i b1 = _mm_xor_si128(_mm_loadu_si128(in + i + 1), key);
+        __m128i b2 = _mm_xor_si128(_mm_loadu_si128(in + i + 2), key);
+        __m128i b3 = _mm_xor_si128(_mm_loadu_si128(in + i + 3), key);
+        __m128i b4 = _mm_xor_si128(_mm_loadu_si128(in + i + 4), key);
+        __m128i b5 = _mm_xor_si128(_mm_loadu_si128(in + i + 5), key);
+        __m128i b6 = _mm_xor_si128(_mm_loadu_si128(in + i + 6), key);
+        __m128i b7 = _mm_xor_si128(_mm_loadu_si128(in + i + 7), key);
+
+        for (int round = 1; round < Rounds; ++round) {
+            key = _mm_loadu_si128(rk + round);
+            b0 = _mm_aesenc_si128(b0, key);
+            b1 = _mm_aesenc_si128(b1, key);
+            b2 = _mm_aesenc_si128(b2, key);
+            b3 = _mm_aesenc_si128(b3, key);
+            b4 = _mm_aesenc_si128(b4, key);
+            b5 = _mm_aesenc_si128(b5, key);
+            b6 = _mm_aesenc_si128(b6, key);
+            b7 = _mm_aesenc_si128(b7, key);
+        }
+
+        key = _mm_loadu_si128(rk + Rounds);
+        _mm_storeu_si128(out + i,     _mm_aesenclast_si128(b0, key));
+        _mm_storeu_si128(out + i + 1, _mm_aesenclast_si128(b1, key));
+        _mm_storeu_si128(out + i + 2, _mm_aesenclast_si128(b2, key));
+        _mm_storeu_si128(out + i + 3, _mm_aesenclast_si128(b3, key));
+        _mm_storeu_si128(out + i + 4, _mm_aesenclast_si128(b4, key));
+        _mm_storeu_si128(out + i + 5, _mm_aesenclast_si128(b5, key));
+        _mm_storeu_si128(out + i + 6, _mm_aesenclast_si128(b6, key));
+        _mm_storeu_si128(out + i + 7, _mm_aesenclast_si128(b7, key));
+    }
+
+    for (; i < numBlocks; ++i) {
+        EncryptBlockNI<Rounds>(roundKeys, input + (i * 16), output + (i * 16));
+    }
+}
+
+// Same eight-wide interleave with a separate schedule per block. The extra round-key
+// loads hit L1 and issue alongside AESENC, so a batch of short messages under
+// different keys runs close to the single-key rate.
+template <int Rounds>
+void EncryptBlocksMultiKeyNI(const uint8_t* const* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks) {
+    const __m128i* in = reinterpret_cast<const __m128i*>(input);
+    __m128i* out = reinterpret_cast<__m128i*>(output);
+    size_t i = 0;
+
+    for (; i + 8 <= numBlocks; i += 8) {
+        const __m128i* k0 = reinterpret_cast<const __m128i*>(roundKeys[i]);
+        const __m128i* k1 = reinterpret_cast<const __m128i*>(roundKeys[i + 1]);
+        const __m128i* k2 = reinterpret_cast<const __m128i*>(roundKeys[i + 2]);
+        const __m128i* k3 = reinterpret_cast<const __m128i*>(roundKeys[i + 3]);
+        const __m128i* k4 = reinterpret_cast<const __m128i*>(roundKeys[i + 4]);
+        const __m128i* k5 = reinterpret_cast<const __m128i*>(roundKeys[i + 5]);
+        const __m128i* k6 = reinterpret_cast<const __m128i*>(roundKeys[i + 6]);
+        const __m128i* k7 = reinterpret_cast<const __m128i*>(roundKeys[i + 7]);
+        __m128i b0 = _mm_xor_si128(_mm_loadu_si128(in + i),     _mm_loadu_si128(k0));
+        __m128i b1 = _mm_xor_si128(_mm_loadu_si128(in + i + 1), _mm_loadu_si128(k1));
+        __m128i b2 = _mm_xor_si128(_mm_loadu_si128(in + i + 2), _mm_loadu_si128(k2));
+        __m128i b3 = _mm_xor_si128(_mm_loadu_si128(in + i + 3), _mm_loadu_si128(k3));
+        __m128i b4 = _mm_xor_si128(_mm_loadu_si128(in + i + 4), _mm_loadu_si128(k4));
+        __m128i b5 = _mm_xor_si128(_mm_loadu_si128(in + i + 5), _mm_loadu_si128(k5));
+        __m128i b6 = _mm_xor_si128(_mm_loadu_si128(in + i + 6), _mm_loadu_si128(k6));
+        __m128i b7 = _mm_xor_si128(_mm_loadu_si128(in + i + 7), _mm_loadu_si128(k7));
+
+        for (int round = 1; round < Rounds; ++round) {
+            b0 = _mm_aesenc_si128(b0, _mm_loadu_si128(k0 + round));
+            b1 = _mm_aesenc_si128(b1, _mm_loadu_si128(k1 + round));
+            b2 = _mm_aesenc_si128(b2, _mm_loadu_si128(k2 + round));
+            b3 = _mm_aesenc_si128(b3, _mm_loadu_si128(k3 + round));
+            b4 = _mm_aesenc_si128(b4, _mm_loadu_si128(k4 + round));
+            b5 = _mm_aesenc_si128(b5, _mm_loadu_si128(k5 + round));
+            b6 = _mm_aesenc_si128(b6, _mm_loadu_si128(k6 + round));
+            b7 = _mm_aesenc_si128(b7, _mm_loadu_si128(k7 + round));
+        }
+
+        _mm_storeu_si128(out + i,     _mm_aesenclast_si128(b0, _mm_loadu_si128(k0 + Rounds)));
+        _mm_storeu_si128(out + i + 1, _mm_aesenclast_si128(b1, _mm_loadu_si128(k1 + Rounds)));
+        _mm_storeu_si128(out + i + 2, _mm_aesenclast_si128(b2, _mm_loadu_si128(k2 + Rounds)));
+        _mm_storeu_si128(out + i + 3, _mm_aesenclast_si128(b3, _mm_loadu_si128(k3 + Rounds)));
+        _mm_storeu_si128(out + i + 4, _mm_aesenclast_si128(b4, _mm_loadu_si128(k4 + Rounds)));
+        _mm_storeu_si128(out + i + 5, _mm_aesenclast_si128(b5, _mm_loadu_si128(k5 + Rounds)));
+        _mm_storeu_si128(out + i + 6, _mm_aesenclast_si128(b6, _mm_loadu_si128(k6 + Rounds)));
+        _mm_storeu_si128(out + i + 7, _mm_aesenclast_si128(b7, _mm_loadu_si128(k7 + Rounds)));
+    }
+
+    for (; i < numBlocks; ++i) {
+        EncryptBlockNI<Rounds>(roundKeys[i], input + (i * 16), output + (i * 16));
+    }
+}
+
+template <int Rounds>
+void DecryptBlockNI(const uint8_t* decKeys, const uint8_t* input, uint8_t* output) {
+    const __m128i* rk = reinterpret_cast<const __m128i*>(decKeys);
+    __m128i state = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input)), _mm_loadu_si128(rk));
+
+    for (int round = 1; round < Rounds; ++round) {
+        state = _mm_aesdec_si128(state, _mm_loadu_si128(rk + round));
+    }
+    state = _mm_aesdeclast_si128(state, _mm_loadu_si128(rk + Rounds));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), state);
+}
+
+template void EncryptBlockNI<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockNI<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockNI<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockNI<14>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlocksNI<7>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksNI<10>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksNI<12>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksNI<14>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksMultiKeyNI<7>(const uint8_t* const*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksMultiKeyNI<10>(const uint8_t* const*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksMultiKeyNI<12>(const uint8_t* const*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksMultiKeyNI<14>(const uint8_t* const*, const uint8_t*, uint8_t*, size_t);
+template void DecryptBlockNI<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockNI<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockNI<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockNI<14>(const uint8_t*, const uint8_t*, uint8_t*);
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#else
+
+template <int Rounds>
+void EncryptBlockNI(const uint8_t*, const uint8_t*, uint8_t*) {
+    throw std::runtime_error("AES-NI backend is not available on this architecture.");
+}
+
+template <int Rounds>
+void EncryptBlocksNI(const uint8_t*, const uint8_t*, uint8_t*, size_t) {
+    throw std::runtime_error("AES-NI backend is not available on this architecture.");
+}
+
+template <int Rounds>
+void EncryptBlocksMultiKeyNI(const uint8_t* const*, const uint8_t*, uint8_t*, size_t) {
+    throw std::runtime_error("AES-NI backend is not available on this architecture.");
+}
+
+template <int Rounds>
+void DecryptBlockNI(const uint8_t*, const uint8_t*, uint8_t*) {
+    throw std::runtime_error("AES-NI backend is not available on this architecture.");
+}
+
+template void EncryptBlockNI<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockNI<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockNI<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockNI<14>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlocksNI<7>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksNI<10>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksNI<12>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksNI<14>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksMultiKeyNI<7>(const uint8_t* const*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksMultiKeyNI<10>(const uint8_t* const*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksMultiKeyNI<12>(const uint8_t* const*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksMultiKeyNI<14>(const uint8_t* const*, const uint8_t*, uint8_t*, size_t);
+template void DecryptBlockNI<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockNI<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockNI<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockNI<14>(const uint8_t*, const uint8_t*, uint8_t*);
+
+#endif
+
+} // namespace AESCore
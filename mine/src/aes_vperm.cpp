@@ -0,0 +1,321 @@
+#include "aes_core.hpp"
+#include "aes_tower.hpp"
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define VPERM_AVAILABLE 1
+#include <immintrin.h>
+#endif
+
+namespace AESCore {
+
+// Vector-permute engine (after Hamburg, "Accelerating AES with Vector Permute
+// Instructions"). GF(2^8) is rewritten as the tower GF(16)[Y]/(Y^2 + Y + lambda), where
+// inversion needs only GF(16) inverses of nibbles. Every GF(16) function is a 16-entry
+// table held in a register and evaluated with PSHUFB, so no memory access depends on
+// key or data.
+//
+// With A = 1/lambda, a byte is mapped to the tower element (A*i)*Y + k, whose norm is
+// Q = A*i^2 + A*i*k + k^2. For j = i ^ k:
+//     io = j ^ 1/(1/i ^ A/k) = Q / (k ^ A*i)
+//     jo = i ^ 1/(1/j ^ A/k) = Q / (k ^ A*j)
+// and both coordinates of the inverse are GF(16)-linear in 1/io and 1/jo, so they are
+// folded into the output tables together with the change of basis back (and, for
+// encryption, the affine map). 1/0 is encoded as 0x80, which PSHUFB reads as 0.
+
+using namespace Tower;
+
+// PSHUFB on a single lane
+constexpr uint8_t Shuffle(const uint8_t* table, uint8_t index) {
+    return (index & 0x80) ? 0 : table[index & 0x0f];
+}
+
+struct VPermTables {
+    // Polynomial basis -> (i << 4 | k), split by input nibble. The decryption map
+    // includes InvAffine(x ^ 0x63), with the constant folded into the low-nibble table.
+    alignas(16) uint8_t encInLo[16], encInHi[16];
+    alignas(16) uint8_t decInLo[16], decInHi[16];
+    // GF(16) 1/x and A/x, both with 1/0 encoded as 0x80
+    alignas(16) uint8_t inv[16], invA[16];
+    // Tower -> polynomial basis as functions of io and jo. Encryption also applies the
+    // linear part of the affine map; its 0x63 is added separately.
+    alignas(16) uint8_t encOutI[16], encOutJ[16];
+    alignas(16) uint8_t decOutI[16], decOutJ[16];
+    // Scalar model of the vector S-boxes, checked against the reference tables below
+    uint8_t sbox[256], rsbox[256];
+    bool valid;
+};
+
+constexpr VPermTables MakeVPermTables() {
+    VPermTables t{};
+
+    constexpr Basis basis = MakeBasis();
+    const uint8_t lambda = basis.lambda;
+    const uint8_t A = Inv4(lambda);
+
+    // Polynomial basis -> (i << 4 | k) = (lambda*alpha << 4 | beta), and the tower -> polynomial map
+    const uint8_t (&toPoly)[256] = basis.toPoly;
+    uint8_t toInput[256] = {};
+    for (int x = 0; x < 256; ++x) {
+        uint8_t tower = basis.toTower[x];
+        toInput[x] = static_cast<uint8_t>((Mul4(lambda, static_cast<uint8_t>(tower >> 4)) << 4) | (tower & 0x0f));
+    }
+
+    const uint8_t decBase = toInput[InvAffine(0x63)];
+    const uint8_t c = Mul4(static_cast<uint8_t>(1 ^ A), lambda);  // (1 + A) / A
+    for (int n = 0; n < 16; ++n) {
+        t.encInLo[n] = toInput[n];
+        t.encInHi[n] = toInput[n << 4];
+        t.decInLo[n] = toInput[InvAffine(static_cast<uint8_t>(n ^ 0x63))];
+        t.decInHi[n] = static_cast<uint8_t>(toInput[InvAffine(static_cast<uint8_t>((n << 4) ^ 0x63))] ^ decBase);
+
+        uint8_t w = Inv4(static_cast<uint8_t>(n));
+        t.inv[n] = n ? w : 0x80;
+        t.invA[n] = n ? Mul4(A, w) : 0x80;
+
+        // Inverse = u*Y + w with w = 1/io and u = (1/jo) / A ^ c / io
+        uint8_t fromI = toPoly[(Mul4(c, w) << 4) | w];
+        uint8_t fromJ = toPoly[Mul4(lambda, w) << 4];
+        t.encOutI[n] = Affine(fromI);
+        t.encOutJ[n] = Affine(fromJ);
+        t.decOutI[n] = fromI;
+        t.decOutJ[n] = fromJ;
+    }
+
+    auto invert = [&](uint8_t in, const uint8_t* outI, const uint8_t* outJ) {
+        uint8_t i = static_cast<uint8_t>(in >> 4);
+        uint8_t k = static_cast<uint8_t>(in & 0x0f);
+        uint8_t j = static_cast<uint8_t>(i ^ k);
+        uint8_t ak = Shuffle(t.invA, k);
+        uint8_t io = static_cast<uint8_t>(Shuffle(t.inv, static_cast<uint8_t>(Shuffle(t.inv, i) ^ ak)) ^ j);
+        uint8_t jo = static_cast<uint8_t>(Shuffle(t.inv, static_cast<uint8_t>(Shuffle(t.inv, j) ^ ak)) ^ i);
+        return static_cast<uint8_t>(Shuffle(outI, io) ^ Shuffle(outJ, jo));
+    };
+
+    t.valid = true;
+    for (int x = 0; x < 256; ++x) {
+        uint8_t s = SBox(static_cast<uint8_t>(x));
+        t.sbox[x] = static_cast<uint8_t>(invert(static_cast<uint8_t>(t.encInLo[x & 0x0f] ^ t.encInHi[x >> 4]), t.encOutI, t.encOutJ) ^ 0x63);
+        t.rsbox[s] = invert(static_cast<uint8_t>(t.decInLo[s & 0x0f] ^ t.decInHi[s >> 4]), t.decOutI, t.decOutJ);
+        if (t.sbox[x] != s) t.valid = false;
+    }
+    for (int x = 0; x < 256; ++x) {
+        if (t.sbox[t.rsbox[x]] != x) t.valid = false;
+    }
+    return t;
+}
+
+static constexpr VPermTables vperm = MakeVPermTables();
+
+static_assert(vperm.valid, "Vector-permute S-box construction");
+
+#ifdef VPERM_AVAILABLE
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("ssse3"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+#endif
+
+static inline __m128i LoadTable(const uint8_t* table) {
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(table));
+}
+
+// All constants live in registers for the duration of a call
+struct VPermRegs {
+    __m128i inLo, inHi, outI, outJ;
+    __m128i inv, invA;
+    __m128i mask0f, reduce;
+
+    explicit VPermRegs(bool decrypt) {
+        inLo = LoadTable(decrypt ? vperm.decInLo : vperm.encInLo);
+        inHi = LoadTable(decrypt ? vperm.decInHi : vperm.encInHi);
+        outI = LoadTable(decrypt ? vperm.decOutI : vperm.encOutI);
+        outJ = LoadTable(decrypt ? vperm.decOutJ : vperm.encOutJ);
+        inv = LoadTable(vperm.inv);
+        invA = LoadTable(vperm.invA);
+        mask0f = _mm_set1_epi8(0x0f);
+        reduce = _mm_set1_epi8(0x1b);
+    }
+};
+
+// Field inversion plus the tables' basis changes on all 16 bytes. With the encryption
+// tables this is SubBytes without its 0x63; with the decryption tables, InvSubBytes.
+static inline __m128i SubBytesV(const VPermRegs& c, __m128i x) {
+    __m128i t = _mm_xor_si128(_mm_shuffle_epi8(c.inLo, _mm_and_si128(x, c.mask0f)),
+                              _mm_shuffle_epi8(c.inHi, _mm_and_si128(_mm_srli_epi16(x, 4), c.mask0f)));
+    __m128i k = _mm_and_si128(t, c.mask0f);
+    __m128i i = _mm_and_si128(_mm_srli_epi16(t, 4), c.mask0f);
+    __m128i j = _mm_xor_si128(i, k);
+
+    __m128i ak = _mm_shuffle_epi8(c.invA, k);
+    __m128i iak = _mm_xor_si128(_mm_shuffle_epi8(c.inv, i), ak);
+    __m128i jak = _mm_xor_si128(_mm_shuffle_epi8(c.inv, j), ak);
+    __m128i io = _mm_xor_si128(_mm_shuffle_epi8(c.inv, iak), j);
+    __m128i jo = _mm_xor_si128(_mm_shuffle_epi8(c.inv, jak), i);
+
+    return _mm_xor_si128(_mm_shuffle_epi8(c.outI, io), _mm_shuffle_epi8(c.outJ, jo));
+}
+
+static inline __m128i XtimeV(const VPermRegs& c, __m128i x) {
+    __m128i carry = _mm_cmpgt_epi8(_mm_setzero_si128(), x);
+    return _mm_xor_si128(_mm_add_epi8(x, x), _mm_and_si128(carry, c.reduce));
+}
+
+// Byte permutations of the column-major state
+static inline __m128i ShiftRowsV(__m128i x) {
+    return _mm_shuffle_epi8(x, _mm_setr_epi8(0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11));
+}
+
+static inline __m128i InvShiftRowsV(__m128i x) {
+    return _mm_shuffle_epi8(x, _mm_setr_epi8(0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3));
+}
+
+static inline __m128i RotateRows1(__m128i x) {
+    return _mm_shuffle_epi8(x, _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12));
+}
+
+static inline __m128i RotateRows2(__m128i x) {
+    return _mm_shuffle_epi8(x, _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+}
+
+// out_r = 2(a_r ^ a_r+1) ^ a_r+1 ^ a_r+2 ^ a_r+3
+static inline __m128i MixColumnsV(const VPermRegs& c, __m128i x) {
+    __m128i r1 = RotateRows1(x);
+    __m128i t = _mm_xor_si128(x, r1);
+    return _mm_xor_si128(_mm_xor_si128(XtimeV(c, t), r1), RotateRows2(t));
+}
+
+// InvMixColumns = MixColumns after a_r ^= 4(a_r ^ a_r+2)
+static inline __m128i InvMixColumnsV(const VPermRegs& c, __m128i x) {
+    __m128i u = XtimeV(c, XtimeV(c, _mm_xor_si128(x, RotateRows2(x))));
+    return MixColumnsV(c, _mm_xor_si128(x, u));
+}
+
+// The S-box constant 0x63 in every byte is unchanged by ShiftRows and MixColumns, so it
+// is added to the round key instead of to each S-box output.
+static inline __m128i RoundKeyV(const __m128i* rk, int round) {
+    return _mm_xor_si128(_mm_loadu_si128(rk + round), _mm_set1_epi8(0x63));
+}
+
+template <int Rounds>
+static inline __m128i EncryptV(const VPermRegs& c, const __m128i* rk, __m128i state) {
+    state = _mm_xor_si128(state, _mm_loadu_si128(rk));
+    for (int round = 1; round < Rounds; ++round) {
+        state = _mm_xor_si128(MixColumnsV(c, ShiftRowsV(SubBytesV(c, state))), RoundKeyV(rk, round));
+    }
+    return _mm_xor_si128(ShiftRowsV(SubBytesV(c, state)), RoundKeyV(rk, Rounds));
+}
+
+template <int Rounds>
+void EncryptBlockVP(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output) {
+    const VPermRegs c(false);
+    const __m128i* rk = reinterpret_cast<const __m128i*>(roundKeys);
+    __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), EncryptV<Rounds>(c, rk, state));
+}
+
+// Four blocks per pass: each S-box is a chain of dependent shuffles, and independent
+// blocks keep the shuffle unit busy while a chain waits.
+template <int Rounds>
+void EncryptBlocksVP(const uint8_t* roundKeys, const uint8_t* input, uint8_t* output, size_t numBlocks) {
+    const VPermRegs c(false);
+    const __m128i* rk = reinterpret_cast<const __m128i*>(roundKeys);
+    const __m128i* in = reinterpret_cast<const __m128i*>(input);
+    __m128i* out = reinterpret_cast<__m128i*>(output);
+    size_t i = 0;
+
+    for (; i + 4 <= numBlocks; i += 4) {
+        __m128i key = _mm_loadu_si128(rk);
+        __m128i b0 = _mm_xor_si128(_mm_loadu_si128(in + i),     key);
+        __m128i b1 = _mm_xor_si128(_mm_loadu_si128(in + i + 1), key);
+        __m128i b2 = _mm_xor_si128(_mm_loadu_si128(in + i + 2), key);
+        __m128i b3 = _mm_xor_si128(_mm_loadu_si128(in + i + 3), key);
+        for (int round = 1; round < Rounds; ++round) {
+            key = RoundKeyV(rk, round);
+            b0 = _mm_xor_si128(MixColumnsV(c, ShiftRowsV(SubBytesV(c, b0))), key);
+            b1 = _mm_xor_si128(MixColumnsV(c, ShiftRowsV(SubBytesV(c, b1))), key);
+            b2 = _mm_xor_si128(MixColumnsV(c, ShiftRowsV(SubBytesV(c, b2))), key);
+            b3 = _mm_xor_si128(MixColumnsV(c, ShiftRowsV(SubBytesV(c, b3))), key);
+        }
+        key = RoundKeyV(rk, Rounds);
+        _mm_storeu_si128(out + i,     _mm_xor_si128(ShiftRowsV(SubBytesV(c, b0)), key));
+        _mm_storeu_si128(out + i + 1, _mm_xor_si128(ShiftRowsV(SubBytesV(c, b1)), key));
+        _mm_storeu_si128(out + i + 2, _mm_xor_si128(ShiftRowsV(SubBytesV(c, b2)), key));
+        _mm_storeu_si128(out + i + 3, _mm_xor_si128(ShiftRowsV(SubBytesV(c, b3)), key));
+    }
+
+    for (; i < numBlocks; ++i) {
+        _mm_storeu_si128(out + i, EncryptV<Rounds>(c, rk, _mm_loadu_si128(in + i)));
+    }
+}
+
+// Equivalent inverse cipher on the InvertKeySchedule output, like DecryptBlockT
+template <int Rounds>
+void DecryptBlockVP(const uint8_t* decKeys, const uint8_t* input, uint8_t* output) {
+    const VPermRegs c(true);
+    const __m128i* rk = reinterpret_cast<const __m128i*>(decKeys);
+    __m128i state = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input)), _mm_loadu_si128(rk));
+
+    for (int round = 1; round < Rounds; ++round) {
+        state = InvMixColumnsV(c, InvShiftRowsV(SubBytesV(c, state)));
+        state = _mm_xor_si128(state, _mm_loadu_si128(rk + round));
+    }
+    state = _mm_xor_si128(InvShiftRowsV(SubBytesV(c, state)), _mm_loadu_si128(rk + Rounds));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), state);
+}
+
+template void EncryptBlockVP<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockVP<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockVP<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockVP<14>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlocksVP<7>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksVP<10>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksVP<12>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksVP<14>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void DecryptBlockVP<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockVP<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockVP<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockVP<14>(const uint8_t*, const uint8_t*, uint8_t*);
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#else
+
+template <int Rounds>
+void EncryptBlockVP(const uint8_t*, const uint8_t*, uint8_t*) {
+    throw std::runtime_error("Vector-permute backend is not available on this architecture.");
+}
+
+template <int Rounds>
+void EncryptBlocksVP(const uint8_t*, const uint8_t*, uint8_t*, size_t) {
+    throw std::runtime_error("Vector-permute backend is not available on this architecture.");
+}
+
+template <int Rounds>
+void DecryptBlockVP(const uint8_t*, const uint8_t*, uint8_t*) {
+    throw std::runtime_error("Vector-permute backend is not available on this architecture.");
+}
+
+template void EncryptBlockVP<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockVP<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockVP<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlockVP<14>(const uint8_t*, const uint8_t*, uint8_t*);
+template void EncryptBlocksVP<7>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksVP<10>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksVP<12>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void EncryptBlocksVP<14>(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+template void DecryptBlockVP<7>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockVP<10>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockVP<12>(const uint8_t*, const uint8_t*, uint8_t*);
+template void DecryptBlockVP<14>(const uint8_t*, const uint8_t*, uint8_t*);
+
+#endif
+
+} // namespace AESCore
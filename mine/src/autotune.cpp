@@ -0,0 +1,217 @@
+#include "autotune.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace Autotune {
+
+// Every task must carry at least this many times the dispatch cost in cipher work
+static constexpr double TASK_TO_DISPATCH_RATIO = 4.0;
+static constexpr size_t MEASURE_BATCH = 32;
+
+using Clock = std::chrono::steady_clock;
+
+// Entries are keyed by backend, round count and the worker count of the pool they were
+// measured on, since the dispatch cost depends on the pool
+using Key = std::tuple<int, int, unsigned int>;
+
+struct Registry {
+    std::mutex mutex;
+    // Entries are never replaced once created, so references handed out stay valid
+    std::map<Key, Params> entries;
+    bool profileLoaded = false;
+};
+
+static Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+static Key KeyFor(AESCore::Backend backend, int rounds, unsigned int workers) {
+    return Key(static_cast<int>(backend), rounds, workers);
+}
+
+static Params Derive(double blockNanos, double dispatchNanos) {
+    Params params;
+    params.blockNanos = blockNanos;
+    params.dispatchNanos = dispatchNanos;
+
+    double blocks = blockNanos > 0 ? std::ceil(TASK_TO_DISPATCH_RATIO * dispatchNanos / blockNanos) : 1.0;
+    params.minBlocksPerTask = blocks < 1.0 ? 1 : static_cast<size_t>(blocks);
+    // Two tasks is the smallest split that can beat running inline
+    params.serialCutoff = 2 * params.minBlocksPerTask;
+    return params;
+}
+
+template <int Rounds>
+static double MeasureBlockNanos(const AESCore::BlockKernel<Rounds>& kernel) {
+    alignas(16) uint8_t roundKeys[16 * (Rounds + 1)] = {};
+    alignas(16) uint8_t counters[MEASURE_BATCH * 16] = {};
+    alignas(16) uint8_t keystream[MEASURE_BATCH * 16];
+
+    kernel.encryptBlocks(roundKeys, counters, keystream, MEASURE_BATCH);
+
+    // Run for about a millisecond; the keystream feeds back so the calls cannot be elided
+    size_t blocks = 0;
+    Clock::time_point start = Clock::now();
+    Clock::time_point now = start;
+    while (now - start < std::chrono::milliseconds(1)) {
+        for (int i = 0; i < 16; ++i) {
+            kernel.encryptBlocks(roundKeys, counters, keystream, MEASURE_BATCH);
+            counters[0] ^= keystream[0];
+        }
+        blocks += 16 * MEASURE_BATCH;
+        now = Clock::now();
+    }
+    return std::chrono::duration<double, std::nano>(now - start).count() / static_cast<double>(blocks);
+}
+
+// A pool without workers never dispatches: TaskCount keeps everything inline on it
+static double MeasureDispatchNanos(ThreadPool& pool) {
+    if (pool.workerCount() == 0) return 0;
+    constexpr int SAMPLES = 101;
+    double samples[SAMPLES];
+    pool.runTasks(pool.concurrency(), [](size_t) {});
+    for (int i = 0; i < SAMPLES; ++i) {
+        Clock::time_point start = Clock::now();
+        pool.runTasks(pool.concurrency(), [](size_t) {});
+        samples[i] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+    std::nth_element(samples, samples + SAMPLES / 2, samples + SAMPLES);
+    return samples[SAMPLES / 2];
+}
+
+static AESCore::Backend ParseBackendName(const std::string& name) {
+    const AESCore::Backend all[] = { AESCore::Backend::Reference, AESCore::Backend::TTable, AESCore::Backend::AESNI,
+                                     AESCore::Backend::VPerm, AESCore::Backend::Bitslice };
+    for (AESCore::Backend backend : all) {
+        if (name == AESCore::BackendName(backend)) return backend;
+    }
+    throw std::runtime_error("Unknown backend in tuning profile: " + name);
+}
+
+// Reads the whole file before touching the registry, so a malformed profile adds nothing
+static bool LoadLocked(Registry& registry, const std::string& path) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::map<Key, Params> loaded;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string name;
+        int rounds = 0;
+        double blockNanos = 0, dispatchNanos = 0;
+        unsigned int workers = 0;
+        if (!(fields >> name >> rounds >> blockNanos >> dispatchNanos >> workers) || blockNanos <= 0 ||
+            dispatchNanos < 0) {
+            throw std::runtime_error("Malformed tuning profile line: " + line);
+        }
+        loaded.emplace(KeyFor(ParseBackendName(name), rounds, workers), Derive(blockNanos, dispatchNanos));
+    }
+    for (const auto& entry : loaded) registry.entries.insert(entry);
+    return true;
+}
+
+static void SaveLocked(const Registry& registry, const std::string& path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) throw std::runtime_error("Cannot write tuning profile: " + path);
+    file << "# backend rounds blockNanos dispatchNanos workers\n";
+    for (const auto& entry : registry.entries) {
+        file << AESCore::BackendName(static_cast<AESCore::Backend>(std::get<0>(entry.first))) << ' '
+             << std::get<1>(entry.first) << ' ' << entry.second.blockNanos << ' ' << entry.second.dispatchNanos << ' '
+             << std::get<2>(entry.first) << '\n';
+    }
+}
+
+template <int Rounds>
+const Params& ForKernel(const AESCore::BlockKernel<Rounds>& kernel, ThreadPool& pool) {
+    Registry& registry = GetRegistry();
+    Key key = KeyFor(kernel.backend, Rounds, pool.workerCount());
+    const char* profile = std::getenv("SAES_TUNING_PROFILE");
+    bool useProfile = profile && *profile;
+    double blockNanos = 0;
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        // The profile is only a cache: if it cannot be read, the kernel is measured and
+        // the profile rewritten, and loading is tried again on the next call until it works
+        if (!registry.profileLoaded) {
+            try {
+                if (useProfile) LoadLocked(registry, profile);
+                registry.profileLoaded = true;
+            } catch (const std::exception&) {
+            }
+        }
+        auto found = registry.entries.find(key);
+        if (found != registry.entries.end()) return found->second;
+
+        // The block cost does not depend on the pool: reuse it from another pool's entry
+        for (const auto& entry : registry.entries) {
+            if (std::get<0>(entry.first) == std::get<0>(key) && std::get<1>(entry.first) == Rounds) {
+                blockNanos = entry.second.blockNanos;
+                break;
+            }
+        }
+    }
+
+    // Measured without the lock, so SAES construction for other kernels is not held up;
+    // if two threads race on the same kernel, the first measurement to land is kept
+    if (blockNanos == 0) blockNanos = MeasureBlockNanos(kernel);
+    Params measured = Derive(blockNanos, MeasureDispatchNanos(pool));
+
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto inserted = registry.entries.try_emplace(key, measured);
+    if (inserted.second && useProfile) {
+        try {
+            SaveLocked(registry, profile);
+        } catch (const std::exception&) {
+        }
+    }
+    return inserted.first->second;
+}
+
+size_t TaskCount(const Params& params, size_t numBlocks, unsigned int concurrency) {
+    if (concurrency <= 1 || numBlocks < params.serialCutoff) return 1;
+    size_t tasks = numBlocks / params.minBlocksPerTask;
+    return tasks < concurrency ? tasks : concurrency;
+}
+
+std::vector<Entry> Snapshot() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::vector<Entry> result;
+    for (const auto& entry : registry.entries) {
+        result.push_back({ static_cast<AESCore::Backend>(std::get<0>(entry.first)), std::get<1>(entry.first),
+                           std::get<2>(entry.first), entry.second });
+    }
+    return result;
+}
+
+bool LoadProfile(const std::string& path) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return LoadLocked(registry, path);
+}
+
+void SaveProfile(const std::string& path) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    SaveLocked(registry, path);
+}
+
+template const Params& ForKernel<7>(const AESCore::BlockKernel<7>& kernel, ThreadPool& pool);
+template const Params& ForKernel<10>(const AESCore::BlockKernel<10>& kernel, ThreadPool& pool);
+template const Params& ForKernel<12>(const AESCore::BlockKernel<12>& kernel, ThreadPool& pool);
+template const Params& ForKernel<14>(const AESCore::BlockKernel<14>& kernel, ThreadPool& pool);
+
+} // namespace Autotune
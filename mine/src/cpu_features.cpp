@@ -0,0 +1,65 @@
+#include "cpu_features.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CPU_FEATURES_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace CpuFeatures {
+
+#ifdef CPU_FEATURES_X86
+static void Cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned int>(r[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0 says which register state the OS saves on a context switch; bits 1 and 2 (SSE
+// and AVX) must both be set before YMM registers can be used
+static unsigned long long ReadXcr0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return (static_cast<unsigned long long>(high) << 32) | low;
+#endif
+}
+#endif
+
+static Flags Query() {
+    Flags flags;
+#ifdef CPU_FEATURES_X86
+    unsigned int regs[4] = {0, 0, 0, 0};
+    Cpuid(0, 0, regs);
+    unsigned int maxLeaf = regs[0];
+    bool osxsave = false;
+    if (maxLeaf >= 1) {
+        Cpuid(1, 0, regs);
+        flags.aesni = (regs[2] & (1u << 25)) != 0;
+        flags.ssse3 = (regs[2] & (1u << 9)) != 0;
+        flags.pclmul = (regs[2] & (1u << 1)) != 0;
+        osxsave = (regs[2] & (1u << 27)) != 0;
+    }
+    if (maxLeaf >= 7 && osxsave && (ReadXcr0() & 0x6) == 0x6) {
+        Cpuid(7, 0, regs);
+        flags.avx2 = (regs[1] & (1u << 5)) != 0;
+    }
+#endif
+    return flags;
+}
+
+const Flags& Detect() {
+    static const Flags flags = Query();
+    return flags;
+}
+
+} // namespace CpuFeatures
@@ -0,0 +1,268 @@
+#include "ghash.hpp"
+#include "cpu_features.hpp"
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CLMUL_AVAILABLE 1
+#include <immintrin.h>
+#endif
+
+namespace GHash {
+
+static inline uint64_t LoadBE64(const uint8_t* p) {
+    return (uint64_t(p[0]) << 56) | (uint64_t(p[1]) << 48) | (uint64_t(p[2]) << 40) | (uint64_t(p[3]) << 32) |
+           (uint64_t(p[4]) << 24) | (uint64_t(p[5]) << 16) | (uint64_t(p[6]) << 8) | uint64_t(p[7]);
+}
+
+static inline void StoreBE64(uint8_t* p, uint64_t v) {
+    for (int i = 7; i >= 0; --i) {
+        p[i] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+}
+
+// ---- Table method ------------------------------------------------------------------
+// GCM numbers bits from the most significant bit of byte 0, so multiplying by x is a
+// right shift of the 128-bit big-endian value, folding the dropped bit back in with
+// the polynomial x^128 + x^7 + x^2 + x + 1 (0xE1 in the top byte).
+
+// Reduction of the four bits shifted out by a 4-bit right shift, pre-positioned in the top 16 bits
+static constexpr uint64_t REM_4BIT[16] = {
+    0x0000ull << 48, 0x1C20ull << 48, 0x3840ull << 48, 0x2460ull << 48,
+    0x7080ull << 48, 0x6CA0ull << 48, 0x48C0ull << 48, 0x54E0ull << 48,
+    0xE100ull << 48, 0xFD20ull << 48, 0xD940ull << 48, 0xC560ull << 48,
+    0x9180ull << 48, 0x8DA0ull << 48, 0xA9C0ull << 48, 0xB5E0ull << 48
+};
+
+static void InitTable(uint64_t table[16][2], const uint8_t h[16]) {
+    uint64_t hi = LoadBE64(h);
+    uint64_t lo = LoadBE64(h + 8);
+
+    // table[8] = H, table[4] = H*x, table[2] = H*x^2, table[1] = H*x^3; the rest by linearity
+    table[0][0] = 0;
+    table[0][1] = 0;
+    for (int i = 8; i >= 1; i >>= 1) {
+        table[i][0] = hi;
+        table[i][1] = lo;
+        uint64_t carry = (lo & 1) ? 0xE100000000000000ull : 0;
+        lo = (hi << 63) | (lo >> 1);
+        hi = (hi >> 1) ^ carry;
+    }
+    for (int i = 2; i < 16; i <<= 1) {
+        for (int j = 1; j < i; ++j) {
+            table[i + j][0] = table[i][0] ^ table[j][0];
+            table[i + j][1] = table[i][1] ^ table[j][1];
+        }
+    }
+}
+
+// x = x * H, one nibble at a time from the last byte to the first
+static void MultiplyTable(const uint64_t table[16][2], uint8_t x[16]) {
+    size_t low = x[15] & 0x0f;
+    size_t high = x[15] >> 4;
+    uint64_t zhi = table[low][0];
+    uint64_t zlo = table[low][1];
+
+    for (int i = 15;;) {
+        size_t rem = static_cast<size_t>(zlo & 0x0f);
+        zlo = (zhi << 60) | (zlo >> 4);
+        zhi = (zhi >> 4) ^ REM_4BIT[rem];
+        zhi ^= table[high][0];
+        zlo ^= table[high][1];
+
+        if (--i < 0) break;
+        low = x[i] & 0x0f;
+        high = x[i] >> 4;
+
+        rem = static_cast<size_t>(zlo & 0x0f);
+        zlo = (zhi << 60) | (zlo >> 4);
+        zhi = (zhi >> 4) ^ REM_4BIT[rem];
+        zhi ^= table[low][0];
+        zlo ^= table[low][1];
+    }
+
+    StoreBE64(x, zhi);
+    StoreBE64(x + 8, zlo);
+}
+
+static void UpdateTable(const Key& key, uint8_t state[16], const uint8_t* data, size_t blocks) {
+    for (size_t b = 0; b < blocks; ++b) {
+        for (int i = 0; i < 16; ++i) state[i] ^= data[b * 16 + i];
+        MultiplyTable(key.table, state);
+    }
+}
+
+// ---- Carry-less multiply method ----------------------------------------------------
+
+#ifdef CLMUL_AVAILABLE
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("pclmul,ssse3"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("pclmul,ssse3")
+#endif
+
+// Operands are byte-reversed so the 128-bit lanes hold the bit-reflected polynomials;
+// products then need a one-bit left shift before the usual reduction.
+static inline __m128i ByteSwap(__m128i v) {
+    return _mm_shuffle_epi8(v, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// lo:hi ^= a * b without reduction
+static inline void MultiplyAccumulate(__m128i a, __m128i b, __m128i& lo, __m128i& hi) {
+    __m128i l = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i h = _mm_clmulepi64_si128(a, b, 0x11);
+    __m128i m = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+    lo = _mm_xor_si128(lo, _mm_xor_si128(l, _mm_slli_si128(m, 8)));
+    hi = _mm_xor_si128(hi, _mm_xor_si128(h, _mm_srli_si128(m, 8)));
+}
+
+static inline __m128i Reduce(__m128i lo, __m128i hi) {
+    // Shift the 256-bit product left by one bit
+    __m128i carryLo = _mm_srli_epi32(lo, 31);
+    __m128i carryHi = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i cross = _mm_srli_si128(carryLo, 12);
+    carryHi = _mm_slli_si128(carryHi, 4);
+    carryLo = _mm_slli_si128(carryLo, 4);
+    lo = _mm_or_si128(lo, carryLo);
+    hi = _mm_or_si128(hi, _mm_or_si128(carryHi, cross));
+
+    // Fold the low half modulo x^128 + x^7 + x^2 + x + 1
+    __m128i a = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+    __m128i spill = _mm_srli_si128(a, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(a, 12));
+    __m128i b = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+    b = _mm_xor_si128(b, spill);
+    lo = _mm_xor_si128(lo, b);
+    return _mm_xor_si128(hi, lo);
+}
+
+static inline __m128i MultiplyClmul(__m128i a, __m128i b) {
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    MultiplyAccumulate(a, b, lo, hi);
+    return Reduce(lo, hi);
+}
+
+static void InitClmul(Key& key) {
+    __m128i h = ByteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(key.h)));
+    __m128i power = h;
+    for (int i = 0; i < 4; ++i) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(key.powers[i]), power);
+        power = MultiplyClmul(power, h);
+    }
+}
+
+// Four blocks per reduction: Y' = (Y ^ X0) H^4 ^ X1 H^3 ^ X2 H^2 ^ X3 H
+static void UpdateClmul(const Key& key, uint8_t state[16], const uint8_t* data, size_t blocks) {
+    const __m128i h1 = _mm_load_si128(reinterpret_cast<const __m128i*>(key.powers[0]));
+    const __m128i h2 = _mm_load_si128(reinterpret_cast<const __m128i*>(key.powers[1]));
+    const __m128i h3 = _mm_load_si128(reinterpret_cast<const __m128i*>(key.powers[2]));
+    const __m128i h4 = _mm_load_si128(reinterpret_cast<const __m128i*>(key.powers[3]));
+    const __m128i* in = reinterpret_cast<const __m128i*>(data);
+    __m128i y = ByteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)));
+
+    size_t b = 0;
+    for (; b + 4 <= blocks; b += 4) {
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        MultiplyAccumulate(_mm_xor_si128(y, ByteSwap(_mm_loadu_si128(in + b))), h4, lo, hi);
+        MultiplyAccumulate(ByteSwap(_mm_loadu_si128(in + b + 1)), h3, lo, hi);
+        MultiplyAccumulate(ByteSwap(_mm_loadu_si128(in + b + 2)), h2, lo, hi);
+        MultiplyAccumulate(ByteSwap(_mm_loadu_si128(in + b + 3)), h1, lo, hi);
+        y = Reduce(lo, hi);
+    }
+    for (; b < blocks; ++b) {
+        y = MultiplyClmul(_mm_xor_si128(y, ByteSwap(_mm_loadu_si128(in + b))), h1);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), ByteSwap(y));
+}
+
+static void MultiplyBytesClmul(const uint8_t a[16], const uint8_t b[16], uint8_t out[16]) {
+    __m128i x = ByteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)));
+    __m128i y = ByteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), ByteSwap(MultiplyClmul(x, y)));
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#else
+
+static void InitClmul(Key&) {
+    throw std::runtime_error("Carry-less multiply GHASH is not available on this architecture.");
+}
+
+static void UpdateClmul(const Key&, uint8_t*, const uint8_t*, size_t) {
+    throw std::runtime_error("Carry-less multiply GHASH is not available on this architecture.");
+}
+
+static void MultiplyBytesClmul(const uint8_t*, const uint8_t*, uint8_t*) {
+    throw std::runtime_error("Carry-less multiply GHASH is not available on this architecture.");
+}
+
+#endif
+
+// ---- Dispatch ----------------------------------------------------------------------
+
+void Init(Key& key, const uint8_t h[16], Method method) {
+    if (method == Method::Auto) {
+        const CpuFeatures::Flags& cpu = CpuFeatures::Detect();
+        method = (cpu.pclmul && cpu.ssse3) ? Method::Clmul : Method::Table;
+    } else if (method == Method::Clmul && !(CpuFeatures::Detect().pclmul && CpuFeatures::Detect().ssse3)) {
+        throw std::invalid_argument("Carry-less multiply GHASH not supported on this CPU.");
+    }
+
+    key.method = method;
+    std::memcpy(key.h, h, 16);
+    if (method == Method::Clmul) {
+        InitClmul(key);
+    } else {
+        InitTable(key.table, h);
+    }
+}
+
+void Update(const Key& key, uint8_t state[16], const uint8_t* data, size_t blocks) {
+    if (key.method == Method::Clmul) {
+        UpdateClmul(key, state, data, blocks);
+    } else {
+        UpdateTable(key, state, data, blocks);
+    }
+}
+
+static void Multiply(Method method, const uint8_t a[16], const uint8_t b[16], uint8_t out[16]) {
+    if (method == Method::Clmul) {
+        MultiplyBytesClmul(a, b, out);
+        return;
+    }
+    uint64_t table[16][2];
+    InitTable(table, b);
+    uint8_t x[16];
+    std::memcpy(x, a, 16);
+    MultiplyTable(table, x);
+    std::memcpy(out, x, 16);
+}
+
+void MultiplyByPower(const Key& key, const uint8_t a[16], uint64_t exponent, uint8_t out[16]) {
+    // Square-and-multiply over H, H^2, H^4, ...
+    uint8_t result[16];
+    uint8_t base[16];
+    std::memcpy(result, a, 16);
+    std::memcpy(base, key.h, 16);
+    while (exponent != 0) {
+        if (exponent & 1) Multiply(key.method, result, base, result);
+        exponent >>= 1;
+        if (exponent != 0) Multiply(key.method, base, base, base);
+    }
+    std::memcpy(out, result, 16);
+}
+
+} // namespace GHash
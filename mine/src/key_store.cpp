@@ -0,0 +1,421 @@
+#include "key_store.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <sddl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr char KEY_MAGIC[8] = { 'M', 'R', 'S', 'A', 'K', 'E', 'Y', '1' };
+// Generous bound on a single field: a 16384-bit modulus is 2048 bytes
+static constexpr uint32_t MAX_FIELD_BYTES = 1 << 16;
+// Pause before KeyPool retries a failed generation, doubling up to the maximum
+static constexpr std::chrono::milliseconds RETRY_MIN(100);
+static constexpr std::chrono::milliseconds RETRY_MAX(30000);
+
+// Read-only view of a whole file, unmapped on destruction
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open key file: " + path);
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw std::runtime_error("Cannot read key file: " + path);
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+        if (size == 0) return;
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) bytes = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!bytes) {
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error("Cannot map key file: " + path);
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open key file: " + path);
+        struct stat status;
+        if (fstat(fd, &status) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot read key file: " + path);
+        }
+        size = static_cast<size_t>(status.st_size);
+        if (size > 0) {
+            void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) bytes = static_cast<const uint8_t*>(data);
+        }
+        // The mapping keeps the file contents reachable after the descriptor is closed
+        close(fd);
+        if (size > 0 && !bytes) throw std::runtime_error("Cannot map key file: " + path);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (bytes) UnmapViewOfFile(bytes);
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+#else
+        if (bytes) munmap(const_cast<uint8_t*>(bytes), size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return bytes; }
+    size_t length() const { return size; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+};
+
+// Bounds-checked cursor over the mapped bytes
+class FieldReader {
+public:
+    FieldReader(const uint8_t* data, size_t size, const std::string& path) : data(data), size(size), path(path) {}
+
+    uint32_t readWord() {
+        need(4);
+        uint32_t value = uint32_t(data[offset]) | uint32_t(data[offset + 1]) << 8 |
+                         uint32_t(data[offset + 2]) << 16 | uint32_t(data[offset + 3]) << 24;
+        offset += 4;
+        return value;
+    }
+
+    std::vector<uint8_t> readField() {
+        uint32_t length = readWord();
+        if (length > MAX_FIELD_BYTES) fail();
+        need(length);
+        std::vector<uint8_t> field(data + offset, data + offset + length);
+        offset += length;
+        return field;
+    }
+
+    void need(size_t count) {
+        if (size - offset < count) fail();
+    }
+
+    void skip(size_t count) {
+        need(count);
+        offset += count;
+    }
+
+    bool atEnd() const { return offset == size; }
+    const uint8_t* cursor() const { return data + offset; }
+
+    [[noreturn]] void fail() const { throw std::runtime_error("Malformed key file: " + path); }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+    const std::string& path;
+};
+
+static void AppendWord(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+static void AppendField(std::vector<uint8_t>& out, const std::vector<uint8_t>& field) {
+    AppendWord(out, static_cast<uint32_t>(field.size()));
+    out.insert(out.end(), field.begin(), field.end());
+}
+
+static void AppendFields(std::vector<uint8_t>& out, const std::vector<std::vector<uint8_t>>& fields) {
+    for (const auto& field : fields) AppendField(out, field);
+}
+
+// Overwrites every field, for keys that are about to be dropped
+static void WipeKey(MultiPrimeKey& key) {
+    auto wipe = [](std::vector<uint8_t>& field) { Utils::secureZero(field.data(), field.size()); };
+    wipe(key.n);
+    wipe(key.e);
+    wipe(key.d);
+    for (auto& field : key.primes) wipe(field);
+    for (auto& field : key.exponents) wipe(field);
+    for (auto& field : key.coefficients) wipe(field);
+}
+
+static size_t FieldsSize(const std::vector<std::vector<uint8_t>>& fields) {
+    size_t size = 0;
+    for (const auto& field : fields) size += 4 + field.size();
+    return size;
+}
+
+// Creates path afresh, readable and writable by its owner only from the moment it exists,
+// writes data and flushes it to the device. A leftover file from an interrupted save is
+// removed rather than reused, since a descriptor opened on it earlier would still work.
+static void WritePrivateFile(const std::string& path, const uint8_t* data, size_t size) {
+#ifdef _WIN32
+    // Protected DACL with a single entry: full access for the file's owner
+    PSECURITY_DESCRIPTOR descriptor = NULL;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorA("D:P(A;;FA;;;OW)", SDDL_REVISION_1, &descriptor, NULL)) {
+        throw std::runtime_error("Cannot write key file: " + path);
+    }
+    SECURITY_ATTRIBUTES attributes = { sizeof(attributes), descriptor, FALSE };
+    DeleteFileA(path.c_str());
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, &attributes, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+    LocalFree(descriptor);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot write key file: " + path);
+
+    bool ok = true;
+    while (ok && size > 0) {
+        DWORD chunk = size > (1u << 30) ? (1u << 30) : static_cast<DWORD>(size);
+        DWORD written = 0;
+        ok = WriteFile(file, data, chunk, &written, NULL) && written > 0;
+        data += written;
+        size -= written;
+    }
+    ok = ok && FlushFileBuffers(file);
+    CloseHandle(file);
+    if (!ok) {
+        DeleteFileA(path.c_str());
+        throw std::runtime_error("Cannot write key file: " + path);
+    }
+#else
+    if (unlink(path.c_str()) != 0 && errno != ENOENT) throw std::runtime_error("Cannot remove stale key file: " + path);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0) throw std::runtime_error("Cannot write key file: " + path);
+
+    bool ok = true;
+    while (ok && size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR) continue;
+        ok = written > 0;
+        if (ok) {
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+    ok = fsync(fd) == 0 && ok;
+    ok = close(fd) == 0 && ok;
+    if (!ok) {
+        unlink(path.c_str());
+        throw std::runtime_error("Cannot write key file: " + path);
+    }
+#endif
+}
+
+// Moves temporary over path, durably: once this returns, a crash leaves the new file
+// under path, never an empty or partial one
+static void CommitFile(const std::string& temporary, const std::string& path) {
+#ifdef _WIN32
+    if (!MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileA(temporary.c_str());
+        throw std::runtime_error("Cannot replace key file: " + path);
+    }
+#else
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot replace key file " + path + ": " + error.message());
+    }
+
+    // The rename lives in the directory entry, which has to reach the device as well
+    std::string parent = std::filesystem::path(path).parent_path().string();
+    if (parent.empty()) parent = ".";
+    int directory = open(parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    bool synced = directory >= 0 && fsync(directory) == 0;
+    if (directory >= 0) close(directory);
+    if (!synced) throw std::runtime_error("Cannot sync key file directory: " + parent);
+#endif
+}
+
+void KeyStore::save(const std::string& path, const MultiPrimeKey& key) {
+    size_t count = key.primes.size();
+    if (count < size_t(MRSA::MIN_PRIMES) || count > size_t(MRSA::MAX_PRIMES)) {
+        throw std::invalid_argument("M-RSA key must have between 2 and 5 primes.");
+    }
+
+    // A key without CRT material is stored with it derived, so loading never has to
+    MultiPrimeKey complete;
+    const MultiPrimeKey* source = &key;
+    if (key.exponents.size() != count || key.coefficients.size() != count) {
+        complete = key;
+        MRSA::deriveCrtMaterial(complete);
+        source = &complete;
+    }
+
+    // Sized up front so the serialized key is never reallocated, leaving no unwiped copies
+    std::vector<uint8_t> out;
+    out.reserve(sizeof(KEY_MAGIC) + 4 + 12 + source->n.size() + source->e.size() + source->d.size() +
+                FieldsSize(source->primes) + FieldsSize(source->exponents) + FieldsSize(source->coefficients));
+    out.insert(out.end(), KEY_MAGIC, KEY_MAGIC + sizeof(KEY_MAGIC));
+    AppendWord(out, static_cast<uint32_t>(count));
+    AppendField(out, source->n);
+    AppendField(out, source->e);
+    AppendField(out, source->d);
+    AppendFields(out, source->primes);
+    AppendFields(out, source->exponents);
+    AppendFields(out, source->coefficients);
+    WipeKey(complete);
+
+    std::string temporary = path + ".tmp";
+    try {
+        WritePrivateFile(temporary, out.data(), out.size());
+    } catch (...) {
+        Utils::secureZero(out.data(), out.size());
+        throw;
+    }
+    Utils::secureZero(out.data(), out.size());
+    CommitFile(temporary, path);
+}
+
+MultiPrimeKey KeyStore::load(const std::string& path) {
+    MappedFile file(path);
+    FieldReader reader(file.data(), file.length(), path);
+
+    reader.need(sizeof(KEY_MAGIC));
+    if (std::memcmp(reader.cursor(), KEY_MAGIC, sizeof(KEY_MAGIC)) != 0) reader.fail();
+    reader.skip(sizeof(KEY_MAGIC));
+
+    uint32_t count = reader.readWord();
+    if (count < uint32_t(MRSA::MIN_PRIMES) || count > uint32_t(MRSA::MAX_PRIMES)) reader.fail();
+
+    MultiPrimeKey key;
+    try {
+        key.n = reader.readField();
+        key.e = reader.readField();
+        key.d = reader.readField();
+        for (uint32_t i = 0; i < count; ++i) key.primes.push_back(reader.readField());
+        for (uint32_t i = 0; i < count; ++i) key.exponents.push_back(reader.readField());
+        for (uint32_t i = 0; i < count; ++i) key.coefficients.push_back(reader.readField());
+        if (!reader.atEnd()) reader.fail();
+
+        // Well-formed is not enough: a damaged CRT exponent would decrypt to wrong
+        // plaintexts without any error, and faulty CRT results are exactly what fault
+        // attacks exploit
+        MRSA::checkKey(key);
+    } catch (const std::invalid_argument& error) {
+        WipeKey(key);
+        throw std::runtime_error("Invalid key file " + path + ": " + error.what());
+    } catch (...) {
+        WipeKey(key);
+        throw;
+    }
+    return key;
+}
+
+MultiPrimeKey KeyStore::loadOrGenerate(const std::string& path, int keyLength, int primeCount) {
+    std::error_code error;
+    if (std::filesystem::exists(path, error)) {
+        // An unreadable or damaged file is replaced like a missing one, so the caller can
+        // always start
+        try {
+            MultiPrimeKey key = load(path);
+            if (key.primes.size() == size_t(primeCount) && key.n.size() == size_t(keyLength + 7) / 8) return key;
+            WipeKey(key);
+        } catch (const std::exception&) {
+        }
+    }
+
+    MultiPrimeKey key = MRSA::generateKey(keyLength, primeCount);
+    save(path, key);
+    return key;
+}
+
+KeyPool::KeyPool(int keyLength, size_t depth, int primeCount)
+    : keyLength(keyLength), primeCount(primeCount), depth(depth) {
+    if (depth == 0) throw std::invalid_argument("Key pool depth must be at least 1.");
+    if (primeCount < MRSA::MIN_PRIMES || primeCount > MRSA::maxPrimesFor(keyLength)) {
+        throw std::invalid_argument("Unsupported M-RSA prime count " + std::to_string(primeCount) + " for a " +
+                                    std::to_string(keyLength) + "-bit key.");
+    }
+    worker = std::thread([this] { run(); });
+}
+
+KeyPool::~KeyPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    refill.notify_one();
+    // Waits out at most the key currently being generated
+    worker.join();
+}
+
+void KeyPool::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    std::chrono::milliseconds backoff = RETRY_MIN;
+    while (true) {
+        refill.wait(lock, [this] { return stopping || keys.size() < depth; });
+        if (stopping) return;
+
+        lock.unlock();
+        MultiPrimeKey key;
+        std::exception_ptr error;
+        try {
+            key = MRSA::generateKey(keyLength, primeCount);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        // A failure (entropy, memory) may be transient: it is reported to take() callers
+        // that find the pool empty, and generation is retried after a growing pause
+        if (error) {
+            failure = error;
+            available.notify_all();
+            refill.wait_for(lock, backoff, [this] { return stopping; });
+            backoff = std::min(backoff * 2, RETRY_MAX);
+            continue;
+        }
+        failure = nullptr;
+        backoff = RETRY_MIN;
+        keys.push_back(std::move(key));
+        available.notify_one();
+    }
+}
+
+MultiPrimeKey KeyPool::take() {
+    std::unique_lock<std::mutex> lock(mutex);
+    available.wait(lock, [this] { return !keys.empty() || failure; });
+    if (keys.empty()) std::rethrow_exception(failure);
+
+    MultiPrimeKey key = std::move(keys.front());
+    keys.pop_front();
+    lock.unlock();
+    refill.notify_one();
+    return key;
+}
+
+bool KeyPool::tryTake(MultiPrimeKey& key) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (keys.empty()) return false;
+
+    key = std::move(keys.front());
+    keys.pop_front();
+    lock.unlock();
+    refill.notify_one();
+    return true;
+}
+
+size_t KeyPool::ready() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return keys.size();
+}
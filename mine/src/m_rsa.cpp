@@ -1,167 +1,937 @@
 #include "m_rsa.hpp"
+#include "mont.hpp"
 #include <openssl/bn.h>
 #include <openssl/rsa.h>
 #include <openssl/rand.h>
+#include <openssl/crypto.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <stdexcept>
 #include <memory>
+#include <string>
 
 // Helper to manage BIGNUM memory
 struct BN_CTX_Deleter { void operator()(BN_CTX* ctx) const { BN_CTX_free(ctx); } };
 struct BIGNUM_Deleter { void operator()(BIGNUM* bn) const { BN_clear_free(bn); } };
+struct BN_MONT_CTX_Deleter { void operator()(BN_MONT_CTX* mont) const { BN_MONT_CTX_free(mont); } };
 
-std::vector<uint8_t> MRSA::calculateEuler(BIGNUM* a, BIGNUM* b, BIGNUM* c, BN_CTX* ctx) {
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> p_minus_1(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> q_minus_1(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> r_minus_1(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> phi(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> temp(BN_new());
+// BN_CTX_start / BN_CTX_end as a scope. Every BIGNUM taken from the frame is wiped when
+// the frame closes but keeps its storage in the BN_CTX pool for the next call. Frames
+// nest, so a call can open one while its caller's is still open on the same context.
+//
+// OpenSSL functions given the context take their own temporaries from the pool above
+// the frame, and leave them unwiped. A secret frame, opened by calls that handle private
+// key material, also wipes SCRUB_DEPTH pool entries above itself when it closes, so
+// none of it outlives the call in a reused context. The deepest OpenSSL call made here
+// (BN_mod_exp_mont_consttime, BN_mod_inverse) takes at most 12 of them.
+class BnFrame {
+public:
+    static constexpr int SCRUB_DEPTH = 32;
 
-    // Calculate (a-1), (b-1), (c-1)
-    BN_copy(p_minus_1.get(), a); BN_sub_word(p_minus_1.get(), 1);
-    BN_copy(q_minus_1.get(), b); BN_sub_word(q_minus_1.get(), 1);
-    BN_copy(r_minus_1.get(), c); BN_sub_word(r_minus_1.get(), 1);
+    explicit BnFrame(BN_CTX* ctx, bool secret = false) : ctx(ctx), secret(secret) { BN_CTX_start(ctx); }
+    ~BnFrame() {
+        for (size_t i = 0; i < count; ++i) BN_clear(taken[i]);
+        if (secret) {
+            BN_CTX_start(ctx);
+            for (int i = 0; i < SCRUB_DEPTH; ++i) {
+                BIGNUM* bn = BN_CTX_get(ctx);
+                if (!bn) break;
+                BN_clear(bn);
+            }
+            BN_CTX_end(ctx);
+        }
+        BN_CTX_end(ctx);
+    }
 
-    // phi(n) = (a-1)(b-1)(c-1)
-    BN_mul(temp.get(), p_minus_1.get(), q_minus_1.get(), ctx);
-    BN_mul(phi.get(), temp.get(), r_minus_1.get(), ctx);
+    BnFrame(const BnFrame&) = delete;
+    BnFrame& operator=(const BnFrame&) = delete;
 
-    int numBytes = BN_num_bytes(phi.get());
+    BIGNUM* get() {
+        BIGNUM* bn = count < MAX_TAKEN ? BN_CTX_get(ctx) : nullptr;
+        if (!bn) throw std::runtime_error("M-RSA scratch allocation failed.");
+        taken[count++] = bn;
+        return bn;
+    }
+
+    // bytes as a big-endian number in a BIGNUM from the frame
+    BIGNUM* parse(const uint8_t* bytes, size_t length) {
+        BIGNUM* bn = get();
+        if (!BN_bin2bn(bytes, static_cast<int>(length), bn)) throw std::runtime_error("Failed to parse M-RSA value.");
+        return bn;
+    }
+    BIGNUM* parse(const std::vector<uint8_t>& bytes) { return parse(bytes.data(), bytes.size()); }
+
+private:
+    static constexpr size_t MAX_TAKEN = 16;
+    BN_CTX* ctx;
+    bool secret;
+    BIGNUM* taken[MAX_TAKEN];
+    size_t count = 0;
+};
+
+// The BN_CTX every frame of a call opens on, and encrypt's cached Montgomery context
+struct MRSA::Workspace::Material {
+    std::unique_ptr<BN_CTX, BN_CTX_Deleter> ctx;
+    std::vector<uint8_t> montModulus;
+    std::unique_ptr<BN_MONT_CTX, BN_MONT_CTX_Deleter> mont;
+};
+
+// Everything decrypt needs besides the ciphertext, for primes p_0 .. p_(k-1):
+//   exponents[i]  = d mod (p_i - 1)
+//   partials[i]   = p_0 * ... * p_(i-1)                       (i >= 1)
+//   garner[i]     = partials[i]^-1 mod p_i, in Montgomery form  (i >= 1)
+// Garner's mixed-radix recombination then builds m one prime at a time:
+//   x = m_0;  x += ((m_i - x) * garner_i mod p_i) * partials[i]  for i = 1 .. k-1
+// which only multiplies prime-sized numbers by each other or by a partial product,
+// and leaves x < n without a final reduction.
+//
+// When the native engine is selected the same material is also kept as limbs, each
+// prime's at the width of its MontContext; garnerLimbs are in that engine's factor form.
+// decryptBatch has its own AVX2 lane engines and exponents, at the primes' own widths.
+struct MRSA::PrivateKeyContext::Material {
+    std::unique_ptr<BIGNUM, BIGNUM_Deleter> n;
+    std::vector<std::unique_ptr<BIGNUM, BIGNUM_Deleter>> primes;
+    std::vector<std::unique_ptr<BIGNUM, BIGNUM_Deleter>> exponents;
+    std::vector<std::unique_ptr<BIGNUM, BIGNUM_Deleter>> partials;
+    std::vector<std::unique_ptr<BIGNUM, BIGNUM_Deleter>> garner;
+    std::vector<std::unique_ptr<BN_MONT_CTX, BN_MONT_CTX_Deleter>> monts;
+
+    size_t modulusLimbs = 0;
+    std::vector<MontContext> engines;  // empty when running on OpenSSL
+    std::vector<std::vector<uint64_t>> exponentLimbs;
+    std::vector<std::vector<uint64_t>> partialLimbs;
+    std::vector<std::vector<uint64_t>> garnerLimbs;
+
+    std::vector<MontLanes> lanes;  // empty when decryptBatch runs one decrypt at a time
+    std::vector<std::vector<uint64_t>> laneExponents;
+
+    ~Material() {
+        for (auto& limbs : exponentLimbs) OPENSSL_cleanse(limbs.data(), limbs.size() * sizeof(uint64_t));
+        for (auto& limbs : laneExponents) OPENSSL_cleanse(limbs.data(), limbs.size() * sizeof(uint64_t));
+    }
+
+    // Garner recombination of residues[i] = m mod p_i into m, as big-endian bytes
+    std::vector<uint8_t> recombine(BIGNUM* const* residues, BN_CTX* ctx) const;
+
+    // Decrypts count ciphertexts, 1 to MontLanes::LANES of them, on the lane engines
+    void decryptLanes(const std::vector<uint8_t>* ciphertexts, size_t count, std::vector<uint8_t>* plaintexts,
+                      BN_CTX* ctx) const;
+};
+
+// Public-key state for encrypt. value, accumulator and result are sized for n up front
+// and the BN_CTX pool is warmed by a trial encryption, so later calls reuse their storage.
+struct MRSA::PublicKeyContext::Material {
+    std::unique_ptr<BIGNUM, BIGNUM_Deleter> n;
+    std::unique_ptr<BIGNUM, BIGNUM_Deleter> e;
+    std::unique_ptr<BN_MONT_CTX, BN_MONT_CTX_Deleter> mont;
+    std::unique_ptr<BN_CTX, BN_CTX_Deleter> ctx;
+    std::unique_ptr<BIGNUM, BIGNUM_Deleter> value;
+    std::unique_ptr<BIGNUM, BIGNUM_Deleter> accumulator;
+    std::unique_ptr<BIGNUM, BIGNUM_Deleter> result;
+    uint64_t smallExponent = 0;  // e if it fits in 64 bits, else 0
+    size_t modulusBytes = 0;
+    std::unique_ptr<MontContext> engine;  // native engine for small exponents, if selected
+    std::vector<uint64_t> modulusLimbs;   // n at the engine's width
+
+    // value^e mod n into result; value must already be below n
+    void exponentiate();
+};
+
+static MRSA::Arithmetic ParseArithmetic(const std::string& value) {
+    if (value == "auto") return MRSA::Arithmetic::Auto;
+    if (value == "openssl") return MRSA::Arithmetic::OpenSSL;
+    if (value == "native") return MRSA::Arithmetic::Native;
+    throw std::invalid_argument("Unknown MRSA_ARITHMETIC value: " + value);
+}
+
+static std::atomic<MRSA::Arithmetic>& CurrentArithmetic() {
+    static std::atomic<MRSA::Arithmetic> current([] {
+        const char* env = std::getenv("MRSA_ARITHMETIC");
+        return (env && *env) ? ParseArithmetic(env) : MRSA::Arithmetic::Auto;
+    }());
+    return current;
+}
+
+void MRSA::setArithmetic(Arithmetic arithmetic) {
+    CurrentArithmetic().store(arithmetic);
+}
+
+MRSA::Arithmetic MRSA::arithmetic() {
+    return CurrentArithmetic().load();
+}
+
+// Whether private-key exponentiations modulo a prime of this many limbs run on the
+// native engine under the current setting
+static bool UseNative(size_t limbs) {
+    switch (MRSA::arithmetic()) {
+        case MRSA::Arithmetic::OpenSSL: return false;
+        case MRSA::Arithmetic::Native:  return MontContext::supports(limbs);
+        case MRSA::Arithmetic::Auto:    return MontContext::preferred(limbs);
+    }
+    return false;
+}
+
+// The same policy for the AVX2 lane engines of decryptBatch
+static bool UseLanes(size_t limbs) {
+    switch (MRSA::arithmetic()) {
+        case MRSA::Arithmetic::OpenSSL: return false;
+        case MRSA::Arithmetic::Native:  return MontLanes::supports(limbs);
+        case MRSA::Arithmetic::Auto:    return MontLanes::preferred(limbs);
+    }
+    return false;
+}
+
+// Widest modulus the native decrypt handles: every prime at the widest engine
+static constexpr size_t MAX_MODULUS_LIMBS = MRSA::MAX_PRIMES * MontContext::MAX_LIMBS;
+
+// Fewest ciphertexts decryptBatch puts through the lanes. A set of four lanes costs
+// about two single decrypts, so one or two leftovers are cheaper decrypted alone.
+static constexpr size_t MIN_BATCH_LANES = 3;
+
+static size_t LimbsOf(const BIGNUM* bn) {
+    return (static_cast<size_t>(BN_num_bytes(bn)) + 7) / 8;
+}
+
+// bn as exactly limbs little-endian limbs
+static std::vector<uint64_t> ToLimbs(const BIGNUM* bn, size_t limbs) {
+    std::vector<uint8_t> bytes(limbs * 8);
+    if (BN_bn2binpad(bn, bytes.data(), static_cast<int>(bytes.size())) < 0) {
+        throw std::runtime_error("M-RSA key component does not fit its limb width.");
+    }
+    std::vector<uint64_t> result(limbs);
+    MontContext::fromBytes(bytes.data(), bytes.size(), result.data(), limbs);
+    OPENSSL_cleanse(bytes.data(), bytes.size());
+    return result;
+}
+
+static std::unique_ptr<BIGNUM, BIGNUM_Deleter> ParseBignum(const std::vector<uint8_t>& bytes) {
+    std::unique_ptr<BIGNUM, BIGNUM_Deleter> bn(BN_bin2bn(bytes.data(), static_cast<int>(bytes.size()), nullptr));
+    if (!bn) throw std::runtime_error("Failed to parse M-RSA key component.");
+    return bn;
+}
+
+// Number of pool BIGNUMs grown up front: enough for the deepest call, a decrypt frame
+// and the scrub above it, so a warm workspace never grows the pool
+static constexpr int WARM_BIGNUMS = 16 + BnFrame::SCRUB_DEPTH;
+
+MRSA::Workspace::Workspace(int keyLength) : material(std::make_unique<Material>()) {
+    material->ctx.reset(BN_CTX_new());
+    if (!material->ctx) throw std::runtime_error("M-RSA workspace allocation failed.");
+
+    // Room for the product of two full-width values in every pooled BIGNUM
+    BN_CTX* ctx = material->ctx.get();
+    BN_CTX_start(ctx);
+    bool warmed = true;
+    for (int i = 0; i < WARM_BIGNUMS && warmed; ++i) {
+        BIGNUM* bn = BN_CTX_get(ctx);
+        warmed = bn && BN_set_bit(bn, 2 * keyLength);
+        if (warmed) BN_clear(bn);
+    }
+    BN_CTX_end(ctx);
+    if (!warmed) throw std::runtime_error("M-RSA workspace allocation failed.");
+}
+
+MRSA::Workspace::~Workspace() = default;
+MRSA::Workspace::Workspace(Workspace&& other) noexcept = default;
+MRSA::Workspace& MRSA::Workspace::operator=(Workspace&& other) noexcept = default;
+
+MRSA::Workspace& MRSA::Workspace::local() {
+    static thread_local Workspace workspace;
+    return workspace;
+}
+
+std::vector<uint8_t> MRSA::calculateEuler(const std::vector<BIGNUM*>& primes, Workspace& workspace) {
+    BN_CTX* ctx = workspace.material->ctx.get();
+    BnFrame frame(ctx);
+    BIGNUM* minus1 = frame.get();
+    BIGNUM* phi = frame.get();
+
+    // phi(n) = (p_1-1)(p_2-1)...(p_k-1)
+    BN_one(phi);
+    for (BIGNUM* prime : primes) {
+        if (!BN_copy(minus1, prime) || !BN_sub_word(minus1, 1) || !BN_mul(phi, phi, minus1, ctx)) {
+            throw std::runtime_error("Failed to compute Euler's totient.");
+        }
+    }
+
+    int numBytes = BN_num_bytes(phi);
     std::vector<uint8_t> phi_vec(numBytes);
-    BN_bn2bin(phi.get(), phi_vec.data());
+    BN_bn2bin(phi, phi_vec.data());
     
     return phi_vec;
 }
 
-TriplePrimeKey MRSA::generateKey(int keyLength) {
-    std::unique_ptr<BN_CTX, BN_CTX_Deleter> ctx(BN_CTX_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> a(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> b(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> c(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> n(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> e(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> d(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> phi(BN_new());
-
-    // 1. Generate 3 distinct primes. For a 1024-bit key, each is ~341 bits.
-    int primeLength = keyLength / 3;
-    BN_generate_prime_ex(a.get(), primeLength, 0, nullptr, nullptr, nullptr);
-    BN_generate_prime_ex(b.get(), primeLength, 0, nullptr, nullptr, nullptr);
-    BN_generate_prime_ex(c.get(), keyLength - (2 * primeLength), 0, nullptr, nullptr, nullptr);
-
-    // 2. n = a * b * c
-    BN_mul(n.get(), a.get(), b.get(), ctx.get());
-    BN_mul(n.get(), n.get(), c.get(), ctx.get());
-
-    // 3. phi(n) = (a-1)(b-1)(c-1)
-    std::vector<uint8_t> phi_vec = calculateEuler(a.get(), b.get(), c.get(), ctx.get());
-    BN_bin2bn(phi_vec.data(), phi_vec.size(), phi.get());
-
-    // 4. Set public exponent e (commonly 65537)
-    BN_set_word(e.get(), RSA_F4);
-
-    // 5. Calculate private exponent d: e * d ≡ 1 (mod phi)
-    BN_mod_inverse(d.get(), e.get(), phi.get(), ctx.get());
-
-    TriplePrimeKey key;
-    key.n.resize(BN_num_bytes(n.get())); BN_bn2bin(n.get(), key.n.data());
-    key.e.resize(BN_num_bytes(e.get())); BN_bn2bin(e.get(), key.e.data());
-    key.d.resize(BN_num_bytes(d.get())); BN_bn2bin(d.get(), key.d.data());
-    key.p.resize(BN_num_bytes(a.get())); BN_bn2bin(a.get(), key.p.data());
-    key.q.resize(BN_num_bytes(b.get())); BN_bn2bin(b.get(), key.q.data());
-    key.r.resize(BN_num_bytes(c.get())); BN_bn2bin(c.get(), key.r.data());
+static std::vector<uint8_t> ToBytes(const BIGNUM* bn) {
+    std::vector<uint8_t> bytes(BN_num_bytes(bn));
+    BN_bn2bin(bn, bytes.data());
+    return bytes;
+}
+
+// exponents[i] = d mod (p_i - 1); coefficients[i] = (p_0 ... p_(i-1))^-1 mod p_i, empty for i = 0
+static void DeriveCrtMaterial(const BIGNUM* d, const std::vector<const BIGNUM*>& primes, BN_CTX* ctx,
+                              std::vector<std::vector<uint8_t>>& exponents,
+                              std::vector<std::vector<uint8_t>>& coefficients) {
+    BnFrame frame(ctx);
+    BIGNUM* minus1 = frame.get();
+    BIGNUM* value = frame.get();
+    BIGNUM* partial = frame.get();
+    // Products and differences of the primes are as secret as the primes themselves
+    BN_set_flags(minus1, BN_FLG_CONSTTIME);
+    BN_set_flags(partial, BN_FLG_CONSTTIME);
+
+    exponents.assign(primes.size(), {});
+    coefficients.assign(primes.size(), {});
+    for (size_t i = 0; i < primes.size(); ++i) {
+        if (!BN_copy(minus1, primes[i]) || !BN_sub_word(minus1, 1) || !BN_mod(value, d, minus1, ctx)) {
+            throw std::runtime_error("Failed to derive M-RSA CRT exponent.");
+        }
+        exponents[i] = ToBytes(value);
+        if (i == 0) {
+            if (!BN_copy(partial, primes[0])) throw std::runtime_error("Failed to derive M-RSA CRT coefficient.");
+            continue;
+        }
+
+        if (!BN_mod_inverse(value, partial, primes[i], ctx) || !BN_mul(partial, partial, primes[i], ctx)) {
+            throw std::runtime_error("Failed to derive M-RSA CRT coefficient.");
+        }
+        coefficients[i] = ToBytes(value);
+    }
+}
+
+int MRSA::maxPrimesFor(int keyLength) {
+    if (keyLength < 4096) return 3;
+    if (keyLength < 8192) return 4;
+    return MAX_PRIMES;
+}
+
+// A prime of the given size with p mod e != 1. e is prime, so this is gcd(e, p - 1) = 1
+// and the private exponent exists.
+static void GeneratePrime(BIGNUM* prime, int bits, BN_ULONG e) {
+    do {
+        if (!BN_generate_prime_ex(prime, bits, 0, nullptr, nullptr, nullptr)) {
+            throw std::runtime_error("M-RSA prime generation failed.");
+        }
+    } while (BN_mod_word(prime, e) == 1);
+}
+
+// Encrypts a random probe one byte shorter than n and checks that decrypt recovers it
+static bool RoundTrips(const MultiPrimeKey& key, ThreadPool& pool, MRSA::Workspace& workspace) {
+    size_t length = key.n.size();
+    for (uint8_t byte : key.n) {
+        if (byte != 0) break;
+        --length;
+    }
+    if (length < 2) return false;
+
+    std::vector<uint8_t> probe(length - 1);
+    if (RAND_bytes(probe.data(), static_cast<int>(probe.size())) != 1) throw std::runtime_error("M-RSA key check failed.");
+    probe[0] |= 1;
+    MRSA::PublicKeyContext publicKey(key.n, key.e);
+    MRSA::PrivateKeyContext privateKey(key);
+    return MRSA::decrypt(MRSA::encrypt(probe, publicKey), privateKey, MRSA::CrtMode::Sequential, pool, workspace) == probe;
+}
+
+MultiPrimeKey MRSA::generateKey(int keyLength, int primeCount, ThreadPool& pool, Workspace& workspace) {
+    if (primeCount < MIN_PRIMES || primeCount > maxPrimesFor(keyLength)) {
+        throw std::invalid_argument("Unsupported M-RSA prime count " + std::to_string(primeCount) + " for a " +
+                                    std::to_string(keyLength) + "-bit modulus.");
+    }
+
+    BN_CTX* ctx = workspace.material->ctx.get();
+    BnFrame frame(ctx, true);
+    std::vector<BIGNUM*> primes(primeCount);
+    BIGNUM* n = frame.get();
+    BIGNUM* e = frame.get();
+    BIGNUM* d = frame.get();
+    BIGNUM* phi = frame.get();
+    for (auto& prime : primes) prime = frame.get();
+
+    // 1. Set public exponent e (commonly 65537)
+    BN_set_word(e, RSA_F4);
+
+    // 2. Generate k distinct primes concurrently. For a 1024-bit key and k = 3, each is
+    //    ~341 bits; the last one takes up the remainder.
+    int primeLength = keyLength / primeCount;
+    auto bitsFor = [&](size_t i) { return i + 1 < primes.size() ? primeLength : keyLength - (primeCount - 1) * primeLength; };
+    pool.runTasks(primes.size(), [&](size_t i) { GeneratePrime(primes[i], bitsFor(i), RSA_F4); });
+    // A replacement prime is checked against all the earlier ones again
+    for (size_t i = 1; i < primes.size(); ++i) {
+        for (bool duplicate = true; duplicate;) {
+            duplicate = std::any_of(primes.begin(), primes.begin() + i,
+                                    [&](const BIGNUM* other) { return BN_cmp(primes[i], other) == 0; });
+            if (duplicate) GeneratePrime(primes[i], bitsFor(i), RSA_F4);
+        }
+    }
+
+    // 3. n = p_1 * p_2 * ... * p_k
+    BN_one(n);
+    for (BIGNUM* prime : primes) {
+        BN_mul(n, n, prime, ctx);
+    }
+
+    // 4. phi(n) = (p_1-1)(p_2-1)...(p_k-1)
+    std::vector<uint8_t> phi_vec = calculateEuler(primes, workspace);
+    BN_bin2bn(phi_vec.data(), phi_vec.size(), phi);
+    OPENSSL_cleanse(phi_vec.data(), phi_vec.size());
+
+    // 5. Calculate private exponent d: e * d ≡ 1 (mod phi). phi, d and the primes are
+    //    secret, so the inversion here and the CRT derivation below take the
+    //    constant-time paths.
+    BN_set_flags(phi, BN_FLG_CONSTTIME);
+    BN_set_flags(d, BN_FLG_CONSTTIME);
+    for (BIGNUM* prime : primes) BN_set_flags(prime, BN_FLG_CONSTTIME);
+    if (!BN_mod_inverse(d, e, phi, ctx)) throw std::runtime_error("Failed to derive M-RSA private exponent.");
+
+    MultiPrimeKey key;
+    key.n.resize(BN_num_bytes(n)); BN_bn2bin(n, key.n.data());
+    key.e.resize(BN_num_bytes(e)); BN_bn2bin(e, key.e.data());
+    key.d.resize(BN_num_bytes(d)); BN_bn2bin(d, key.d.data());
+    for (BIGNUM* prime : primes) {
+        key.primes.emplace_back(BN_num_bytes(prime));
+        BN_bn2bin(prime, key.primes.back().data());
+    }
+
+    // 6. CRT material, so loading the key later needs no modular inversions
+    DeriveCrtMaterial(d, std::vector<const BIGNUM*>(primes.begin(), primes.end()), ctx, key.exponents, key.coefficients);
+
+    // 7. Pairwise consistency check through the contexts, and so the arithmetic, that
+    //    will use the key
+    if (!RoundTrips(key, pool, workspace)) {
+        throw std::runtime_error("M-RSA key check failed: decrypt does not invert encrypt.");
+    }
 
     return key;
 }
 
+void MRSA::deriveCrtMaterial(MultiPrimeKey& key) {
+    std::unique_ptr<BN_CTX, BN_CTX_Deleter> ctx(BN_CTX_new());
+    if (!ctx) throw std::runtime_error("M-RSA key allocation failed.");
+    std::unique_ptr<BIGNUM, BIGNUM_Deleter> d = ParseBignum(key.d);
+    BN_set_flags(d.get(), BN_FLG_CONSTTIME);
+    std::vector<std::unique_ptr<BIGNUM, BIGNUM_Deleter>> primes;
+    std::vector<const BIGNUM*> factors;
+    for (const auto& prime : key.primes) {
+        primes.push_back(ParseBignum(prime));
+        factors.push_back(primes.back().get());
+    }
+    DeriveCrtMaterial(d.get(), factors, ctx.get(), key.exponents, key.coefficients);
+}
+
+void MRSA::checkKey(const MultiPrimeKey& key, Workspace& workspace) {
+    size_t count = key.primes.size();
+    if (count < size_t(MIN_PRIMES) || count > size_t(MAX_PRIMES)) {
+        throw std::invalid_argument("M-RSA key must have between 2 and 5 primes.");
+    }
+    bool crt = !key.exponents.empty() || !key.coefficients.empty();
+    if (crt && (key.exponents.size() != count || key.coefficients.size() != count)) {
+        throw std::invalid_argument("M-RSA key has incomplete CRT material.");
+    }
+
+    BN_CTX* ctx = workspace.material->ctx.get();
+    BnFrame frame(ctx, true);
+    BIGNUM* n = frame.parse(key.n);
+    BIGNUM* e = frame.parse(key.e);
+    BIGNUM* d = frame.parse(key.d);
+    BIGNUM* partial = frame.get();
+    BN_set_flags(d, BN_FLG_CONSTTIME);
+    BN_set_flags(partial, BN_FLG_CONSTTIME);
+    BN_one(partial);
+
+    for (size_t i = 0; i < count; ++i) {
+        BnFrame step(ctx);
+        BIGNUM* prime = step.parse(key.primes[i]);
+        BIGNUM* minus1 = step.get();
+        BIGNUM* value = step.get();
+        BN_set_flags(prime, BN_FLG_CONSTTIME);
+        BN_set_flags(minus1, BN_FLG_CONSTTIME);
+        if (!BN_is_odd(prime) || BN_num_bits(prime) < 2) throw std::invalid_argument("M-RSA key has an invalid prime.");
+        if (!BN_copy(minus1, prime) || !BN_sub_word(minus1, 1) || !BN_mod(value, d, minus1, ctx)) {
+            throw std::runtime_error("M-RSA key check failed.");
+        }
+        if (crt && BN_cmp(value, step.parse(key.exponents[i])) != 0) {
+            throw std::invalid_argument("M-RSA CRT exponent does not match d.");
+        }
+        if (!BN_mod_mul(value, value, e, minus1, ctx)) throw std::runtime_error("M-RSA key check failed.");
+        if (!BN_is_one(value)) throw std::invalid_argument("M-RSA private exponent does not invert e.");
+
+        // coefficient_i * p_0 * ... * p_(i-1) = 1 mod p_i
+        if (crt && i == 0 && !key.coefficients[0].empty()) {
+            throw std::invalid_argument("M-RSA CRT coefficient does not match the primes.");
+        }
+        if (crt && i > 0) {
+            if (!BN_mod_mul(value, step.parse(key.coefficients[i]), partial, prime, ctx)) {
+                throw std::runtime_error("M-RSA key check failed.");
+            }
+            if (!BN_is_one(value)) throw std::invalid_argument("M-RSA CRT coefficient does not match the primes.");
+        }
+        if (!BN_mul(partial, partial, prime, ctx)) throw std::runtime_error("M-RSA key check failed.");
+    }
+    if (BN_cmp(partial, n) != 0) throw std::invalid_argument("M-RSA modulus is not the product of the primes.");
+}
+
 std::vector<uint8_t> MRSA::encrypt(const std::vector<uint8_t>& plaintext, 
                                    const std::vector<uint8_t>& n_vec, 
-                                   const std::vector<uint8_t>& e_vec) {
-    std::unique_ptr<BN_CTX, BN_CTX_Deleter> ctx(BN_CTX_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> m(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> e(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> n(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> c(BN_new());
+                                   const std::vector<uint8_t>& e_vec,
+                                   Workspace& workspace) {
+    Workspace::Material& scratch = *workspace.material;
+    BN_CTX* ctx = scratch.ctx.get();
+    BnFrame frame(ctx);
+    BIGNUM* m = frame.parse(plaintext);
+    BIGNUM* e = frame.parse(e_vec);
+    BIGNUM* n = frame.parse(n_vec);
+    BIGNUM* c = frame.get();
+
+    // Senders usually encrypt to the same receiver over and over, so the Montgomery
+    // context of the last odd modulus is kept instead of being rebuilt by BN_mod_exp
+    bool ok;
+    if (BN_is_odd(n)) {
+        if (!scratch.mont || scratch.montModulus != n_vec) {
+            scratch.montModulus.clear();
+            if (!scratch.mont) scratch.mont.reset(BN_MONT_CTX_new());
+            if (!scratch.mont || !BN_MONT_CTX_set(scratch.mont.get(), n, ctx)) {
+                scratch.mont.reset();
+                throw std::runtime_error("Failed to set up Montgomery context.");
+            }
+            scratch.montModulus = n_vec;
+        }
+        ok = BN_mod_exp_mont(c, m, e, n, ctx, scratch.mont.get()) != 0;
+    } else {
+        ok = BN_mod_exp(c, m, e, n, ctx) != 0;
+    }
+    if (!ok) throw std::runtime_error("M-RSA encryption failed.");
+
+    std::vector<uint8_t> ciphertext(BN_num_bytes(c));
+    BN_bn2bin(c, ciphertext.data());
+    return ciphertext;
+}
+
+void MRSA::PublicKeyContext::Material::exponentiate() {
+    BN_CTX* ctx = this->ctx.get();
+    BN_MONT_CTX* mont = this->mont.get();
+    if (smallExponent == 0) {
+        if (!BN_mod_exp_mont(result.get(), value.get(), e.get(), n.get(), ctx, mont)) {
+            throw std::runtime_error("M-RSA encryption failed.");
+        }
+        return;
+    }
+
+    // Left-to-right square-and-multiply; the exponent is public, so branching on its bits
+    // leaks nothing
+    BIGNUM* base = value.get();
+    BIGNUM* acc = accumulator.get();
+    if (!BN_to_montgomery(base, base, mont, ctx) || !BN_copy(acc, base)) {
+        throw std::runtime_error("M-RSA encryption failed.");
+    }
+    int top = 63;
+    while (!(smallExponent >> top & 1)) --top;
+    for (int bit = top - 1; bit >= 0; --bit) {
+        if (!BN_mod_mul_montgomery(acc, acc, acc, mont, ctx) ||
+            ((smallExponent >> bit & 1) && !BN_mod_mul_montgomery(acc, acc, base, mont, ctx))) {
+            throw std::runtime_error("M-RSA encryption failed.");
+        }
+    }
+    if (!BN_from_montgomery(result.get(), acc, mont, ctx)) throw std::runtime_error("M-RSA encryption failed.");
+}
+
+MRSA::PublicKeyContext::PublicKeyContext(const std::vector<uint8_t>& n, const std::vector<uint8_t>& e)
+    : material(std::make_unique<Material>()) {
+    Material& key = *material;
+    key.n = ParseBignum(n);
+    key.e = ParseBignum(e);
+    if (!BN_is_odd(key.n.get()) || BN_is_one(key.n.get())) throw std::invalid_argument("M-RSA modulus must be odd and above 1.");
+    if (BN_is_zero(key.e.get())) throw std::invalid_argument("M-RSA public exponent must be nonzero.");
+
+    key.ctx.reset(BN_CTX_new());
+    key.mont.reset(BN_MONT_CTX_new());
+    key.value.reset(BN_new());
+    key.accumulator.reset(BN_new());
+    key.result.reset(BN_new());
+    if (!key.ctx || !key.mont || !key.value || !key.accumulator || !key.result) {
+        throw std::runtime_error("M-RSA key context allocation failed.");
+    }
+    if (!BN_MONT_CTX_set(key.mont.get(), key.n.get(), key.ctx.get())) {
+        throw std::runtime_error("Failed to set up Montgomery context.");
+    }
+
+    if (BN_num_bits(key.e.get()) <= 64) {
+        for (uint8_t byte : e) key.smallExponent = key.smallExponent << 8 | byte;
+    }
+    key.modulusBytes = BN_num_bytes(key.n.get());
+    size_t limbs = LimbsOf(key.n.get());
+    // A public exponentiation is a handful of multiplies, where OpenSSL's assembly is
+    // faster, so only a forced Native setting moves it to the fixed-width engine
+    if (key.smallExponent != 0 && MRSA::arithmetic() == Arithmetic::Native && MontContext::supports(limbs)) {
+        key.engine = std::make_unique<MontContext>(ToLimbs(key.n.get(), limbs).data(), limbs);
+        key.modulusLimbs = ToLimbs(key.n.get(), key.engine->width());
+    }
+
+    if (key.engine) return;
+
+    // Trial run with a full-width value: grows every BIGNUM and the BN_CTX pool to the
+    // size later calls need
+    if (!BN_sub(key.value.get(), key.n.get(), BN_value_one()) || !BN_copy(key.accumulator.get(), key.n.get()) ||
+        !BN_copy(key.result.get(), key.n.get())) {
+        throw std::runtime_error("M-RSA key context allocation failed.");
+    }
+    key.exponentiate();
+}
+
+MRSA::PublicKeyContext::~PublicKeyContext() = default;
+MRSA::PublicKeyContext::PublicKeyContext(PublicKeyContext&& other) noexcept = default;
+MRSA::PublicKeyContext& MRSA::PublicKeyContext::operator=(PublicKeyContext&& other) noexcept = default;
 
-    BN_bin2bn(plaintext.data(), plaintext.size(), m.get());
-    BN_bin2bn(e_vec.data(), e_vec.size(), e.get());
-    BN_bin2bn(n_vec.data(), n_vec.size(), n.get());
+size_t MRSA::PublicKeyContext::modulusBytes() const {
+    return material->modulusBytes;
+}
 
-    BN_mod_exp(c.get(), m.get(), e.get(), n.get(), ctx.get());
+void MRSA::encrypt(const uint8_t* plaintext, size_t length, uint8_t* ciphertext, PublicKeyContext& publicKey) {
+    PublicKeyContext::Material& key = *publicKey.material;
+    if (length > key.modulusBytes) throw std::invalid_argument("M-RSA plaintext is longer than the modulus.");
+    if (key.engine) {
+        uint64_t value[MontContext::MAX_LIMBS];
+        uint64_t result[MontContext::MAX_LIMBS];
+        size_t width = key.engine->width();
+        MontContext::fromBytes(plaintext, length, value, width);
+        size_t j = width;
+        while (j > 0 && value[j - 1] == key.modulusLimbs[j - 1]) --j;
+        if (j == 0 || value[j - 1] > key.modulusLimbs[j - 1]) {
+            throw std::invalid_argument("M-RSA plaintext must be below the modulus.");
+        }
+        key.engine->modExpPublic(value, width, key.smallExponent, result);
+        MontContext::toBytes(result, width, ciphertext, key.modulusBytes);
+        return;
+    }
+    if (!BN_bin2bn(plaintext, static_cast<int>(length), key.value.get())) throw std::runtime_error("M-RSA encryption failed.");
+    if (BN_ucmp(key.value.get(), key.n.get()) >= 0) throw std::invalid_argument("M-RSA plaintext must be below the modulus.");
+
+    key.exponentiate();
+    if (BN_bn2binpad(key.result.get(), ciphertext, static_cast<int>(key.modulusBytes)) < 0) {
+        throw std::runtime_error("M-RSA encryption failed.");
+    }
+}
 
-    std::vector<uint8_t> ciphertext(BN_num_bytes(c.get()));
-    BN_bn2bin(c.get(), ciphertext.data());
+std::vector<uint8_t> MRSA::encrypt(const std::vector<uint8_t>& plaintext, PublicKeyContext& publicKey) {
+    std::vector<uint8_t> ciphertext(publicKey.modulusBytes());
+    encrypt(plaintext.data(), plaintext.size(), ciphertext.data(), publicKey);
     return ciphertext;
 }
 
-std::vector<uint8_t> MRSA::decrypt(const std::vector<uint8_t>& ciphertext, 
-                                   const TriplePrimeKey& privateKey) {
+MRSA::PrivateKeyContext::PrivateKeyContext(const MultiPrimeKey& key) : material(std::make_unique<Material>()) {
+    size_t count = key.primes.size();
+    if (count < size_t(MIN_PRIMES) || count > size_t(MAX_PRIMES)) {
+        throw std::invalid_argument("M-RSA key must have between 2 and 5 primes.");
+    }
+
     std::unique_ptr<BN_CTX, BN_CTX_Deleter> ctx(BN_CTX_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> c(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> d(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> p(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> q(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> r(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> n(BN_new());
-    
-    BN_bin2bn(ciphertext.data(), ciphertext.size(), c.get());
-    BN_bin2bn(privateKey.d.data(), privateKey.d.size(), d.get());
-    BN_bin2bn(privateKey.p.data(), privateKey.p.size(), p.get());
-    BN_bin2bn(privateKey.q.data(), privateKey.q.size(), q.get());
-    BN_bin2bn(privateKey.r.data(), privateKey.r.size(), r.get());
-    BN_bin2bn(privateKey.n.data(), privateKey.n.size(), n.get());
-
-    // CRT Variables
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> p_minus_1(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> q_minus_1(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> r_minus_1(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> dp(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> dq(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> dr(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> m1(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> m2(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> m3(BN_new());
-
-    BN_copy(p_minus_1.get(), p.get()); BN_sub_word(p_minus_1.get(), 1);
-    BN_copy(q_minus_1.get(), q.get()); BN_sub_word(q_minus_1.get(), 1);
-    BN_copy(r_minus_1.get(), r.get()); BN_sub_word(r_minus_1.get(), 1);
-
-    BN_mod(dp.get(), d.get(), p_minus_1.get(), ctx.get());
-    BN_mod(dq.get(), d.get(), q_minus_1.get(), ctx.get());
-    BN_mod(dr.get(), d.get(), r_minus_1.get(), ctx.get());
-
-    BN_mod_exp(m1.get(), c.get(), dp.get(), p.get(), ctx.get());
-    BN_mod_exp(m2.get(), c.get(), dq.get(), q.get(), ctx.get());
-    BN_mod_exp(m3.get(), c.get(), dr.get(), r.get(), ctx.get());
-
-    // Reconstruct M using CRT
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> qr(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> pr(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> pq(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> qr_inv_p(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> pr_inv_q(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> pq_inv_r(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> t1(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> t2(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> t3(BN_new());
-    std::unique_ptr<BIGNUM, BIGNUM_Deleter> m(BN_new());
-
-    BN_mul(qr.get(), q.get(), r.get(), ctx.get());
-    BN_mul(pr.get(), p.get(), r.get(), ctx.get());
-    BN_mul(pq.get(), p.get(), q.get(), ctx.get());
-
-    BN_mod_inverse(qr_inv_p.get(), qr.get(), p.get(), ctx.get());
-    BN_mod_inverse(pr_inv_q.get(), pr.get(), q.get(), ctx.get());
-    BN_mod_inverse(pq_inv_r.get(), pq.get(), r.get(), ctx.get());
-
-    BN_mul(t1.get(), m1.get(), qr.get(), ctx.get()); BN_mul(t1.get(), t1.get(), qr_inv_p.get(), ctx.get());
-    BN_mul(t2.get(), m2.get(), pr.get(), ctx.get()); BN_mul(t2.get(), t2.get(), pr_inv_q.get(), ctx.get());
-    BN_mul(t3.get(), m3.get(), pq.get(), ctx.get()); BN_mul(t3.get(), t3.get(), pq_inv_r.get(), ctx.get());
-
-    BN_add(m.get(), t1.get(), t2.get());
-    BN_add(m.get(), m.get(), t3.get());
-    BN_mod(m.get(), m.get(), n.get(), ctx.get());
-
-    std::vector<uint8_t> plaintext(BN_num_bytes(m.get()));
-    BN_bn2bin(m.get(), plaintext.data());
+    std::unique_ptr<BIGNUM, BIGNUM_Deleter> coefficient(BN_new());
+    if (!ctx || !coefficient) throw std::runtime_error("M-RSA key context allocation failed.");
+
+    material->n = ParseBignum(key.n);
+    material->primes.resize(count);
+    material->exponents.resize(count);
+    material->partials.resize(count);
+    material->garner.resize(count);
+    material->monts.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        material->primes[i] = ParseBignum(key.primes[i]);
+        BN_set_flags(material->primes[i].get(), BN_FLG_CONSTTIME);
+    }
+
+    // Keys from generateKey or the key store carry their CRT material; derive it otherwise
+    const std::vector<std::vector<uint8_t>>* exponents = &key.exponents;
+    const std::vector<std::vector<uint8_t>>* coefficients = &key.coefficients;
+    std::vector<std::vector<uint8_t>> derivedExponents, derivedCoefficients;
+    if (key.exponents.size() != count || key.coefficients.size() != count) {
+        std::unique_ptr<BIGNUM, BIGNUM_Deleter> d = ParseBignum(key.d);
+        BN_set_flags(d.get(), BN_FLG_CONSTTIME);
+        std::vector<const BIGNUM*> primes;
+        for (const auto& prime : material->primes) primes.push_back(prime.get());
+        DeriveCrtMaterial(d.get(), primes, ctx.get(), derivedExponents, derivedCoefficients);
+        exponents = &derivedExponents;
+        coefficients = &derivedCoefficients;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        BIGNUM* prime = material->primes[i].get();
+        material->exponents[i] = ParseBignum((*exponents)[i]);
+        BN_set_flags(material->exponents[i].get(), BN_FLG_CONSTTIME);
+
+        material->monts[i].reset(BN_MONT_CTX_new());
+        if (!material->monts[i] || !BN_MONT_CTX_set(material->monts[i].get(), prime, ctx.get())) {
+            throw std::runtime_error("Failed to set up Montgomery context.");
+        }
+        if (i == 0) continue;
+
+        // Product of the earlier primes, and the Garner coefficient in Montgomery form so
+        // the per-decrypt multiply by it is a single BN_mod_mul_montgomery
+        material->partials[i].reset(BN_new());
+        material->garner[i].reset(BN_new());
+        BIGNUM* partial = material->partials[i].get();
+        BIGNUM* garner = material->garner[i].get();
+        if (!partial || !garner) throw std::runtime_error("M-RSA key context allocation failed.");
+        bool ok = i == 1 ? BN_copy(partial, material->primes[0].get()) != nullptr
+                         : BN_mul(partial, material->partials[i - 1].get(), material->primes[i - 1].get(), ctx.get()) != 0;
+        if (!ok || !BN_bin2bn((*coefficients)[i].data(), static_cast<int>((*coefficients)[i].size()), coefficient.get()) ||
+            !BN_to_montgomery(garner, coefficient.get(), material->monts[i].get(), ctx.get())) {
+            throw std::runtime_error("Failed to derive M-RSA CRT coefficient.");
+        }
+    }
+
+    material->modulusLimbs = LimbsOf(material->n.get());
+    bool lanes = true;
+    for (size_t i = 0; i < count && lanes; ++i) lanes = UseLanes(LimbsOf(material->primes[i].get()));
+    for (size_t i = 0; i < count && lanes; ++i) {
+        size_t limbs = LimbsOf(material->primes[i].get());
+        material->lanes.emplace_back(ToLimbs(material->primes[i].get(), limbs).data(), limbs);
+        material->laneExponents.push_back(ToLimbs(material->exponents[i].get(), limbs));
+    }
+
+    // Native engines only if every prime gets one, so decrypt has a single path
+    bool native = material->modulusLimbs <= MAX_MODULUS_LIMBS;
+    for (size_t i = 0; i < count && native; ++i) native = UseNative(LimbsOf(material->primes[i].get()));
+    if (!native) return;
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t limbs = LimbsOf(material->primes[i].get());
+        material->engines.emplace_back(ToLimbs(material->primes[i].get(), limbs).data(), limbs);
+        size_t width = material->engines[i].width();
+        material->exponentLimbs.push_back(ToLimbs(material->exponents[i].get(), width));
+        if (i == 0) {
+            material->partialLimbs.emplace_back();
+            material->garnerLimbs.emplace_back();
+            continue;
+        }
+        material->partialLimbs.push_back(ToLimbs(material->partials[i].get(), LimbsOf(material->partials[i].get())));
+        std::unique_ptr<BIGNUM, BIGNUM_Deleter> plain(BN_new());
+        if (!plain || !BN_from_montgomery(plain.get(), material->garner[i].get(), material->monts[i].get(), ctx.get())) {
+            throw std::runtime_error("Failed to derive M-RSA CRT coefficient.");
+        }
+        std::vector<uint64_t> factor = ToLimbs(plain.get(), width);
+        material->garnerLimbs.emplace_back(width);
+        material->engines[i].prepareFactor(factor.data(), material->garnerLimbs[i].data());
+    }
+}
+
+MRSA::PrivateKeyContext::~PrivateKeyContext() = default;
+MRSA::PrivateKeyContext::PrivateKeyContext(PrivateKeyContext&& other) noexcept = default;
+MRSA::PrivateKeyContext& MRSA::PrivateKeyContext::operator=(PrivateKeyContext&& other) noexcept = default;
+
+std::vector<uint8_t> MRSA::decrypt(const std::vector<uint8_t>& ciphertext, 
+                                   const MultiPrimeKey& privateKey,
+                                   Workspace& workspace) {
+    return decrypt(ciphertext, PrivateKeyContext(privateKey), CrtMode::Sequential, ThreadPool::shared(), workspace);
+}
+
+// Garner on the native engines, as in the OpenSSL path, for residues[i] = m mod p_i at
+// engines[i].width() limbs; x never exceeds n, which fits in MAX_MODULUS_LIMBS
+static std::vector<uint8_t> RecombineNative(const uint64_t (*residues)[MontContext::MAX_LIMBS],
+                                            const std::vector<MontContext>& engines,
+                                            const std::vector<std::vector<uint64_t>>& partials,
+                                            const std::vector<std::vector<uint64_t>>& garner, size_t modulusLimbs) {
+    constexpr size_t MAX = MAX_MODULUS_LIMBS;
+    uint64_t x[MAX] = {};
+    uint64_t reduced[MontContext::MAX_LIMBS];
+    uint64_t digit[MontContext::MAX_LIMBS];
+    for (size_t j = 0; j < engines[0].width(); ++j) x[j] = residues[0][j];
+    for (size_t i = 1; i < engines.size(); ++i) {
+        engines[i].reduce(x, modulusLimbs, reduced);
+        engines[i].mulDifference(residues[i], reduced, garner[i].data(), digit);
+        MontContext::mulAdd(x, modulusLimbs, digit, engines[i].width(), partials[i].data(), partials[i].size());
+    }
+
+    // Same output as BN_bn2bin: no leading zero bytes
+    uint8_t bytes[MAX * 8];
+    MontContext::toBytes(x, modulusLimbs, bytes, modulusLimbs * 8);
+    size_t skip = 0;
+    while (skip < modulusLimbs * 8 && bytes[skip] == 0) ++skip;
+    std::vector<uint8_t> plaintext(bytes + skip, bytes + modulusLimbs * 8);
+
+    OPENSSL_cleanse(x, sizeof(x));
+    OPENSSL_cleanse(reduced, sizeof(reduced));
+    OPENSSL_cleanse(digit, sizeof(digit));
+    OPENSSL_cleanse(bytes, sizeof(bytes));
     return plaintext;
-}
\ No newline at end of file
+}
+
+// The CRT decrypt of MRSA::decrypt on the native engines: operands live in fixed-size
+// stack buffers, so nothing is allocated besides the returned plaintext
+static std::vector<uint8_t> DecryptNative(const std::vector<uint8_t>& ciphertext,
+                                          const std::vector<MontContext>& engines,
+                                          const std::vector<std::vector<uint64_t>>& exponents,
+                                          const std::vector<std::vector<uint64_t>>& partials,
+                                          const std::vector<std::vector<uint64_t>>& garner,
+                                          size_t modulusLimbs, MRSA::CrtMode mode, ThreadPool& pool) {
+    constexpr size_t MAX = MAX_MODULUS_LIMBS;
+    uint64_t c[MAX];
+    uint64_t residues[MRSA::MAX_PRIMES][MontContext::MAX_LIMBS];
+    MontContext::fromBytes(ciphertext.data(), ciphertext.size(), c, modulusLimbs);
+
+    size_t count = engines.size();
+    auto exponentiate = [&](size_t i) { engines[i].modExp(c, modulusLimbs, exponents[i].data(), residues[i]); };
+    if (mode == MRSA::CrtMode::Parallel) {
+        pool.runTasks(count, exponentiate);
+    } else {
+        for (size_t i = 0; i < count; ++i) exponentiate(i);
+    }
+
+    std::vector<uint8_t> plaintext = RecombineNative(residues, engines, partials, garner, modulusLimbs);
+    OPENSSL_cleanse(residues, sizeof(residues));
+    return plaintext;
+}
+
+std::vector<uint8_t> MRSA::decrypt(const std::vector<uint8_t>& ciphertext,
+                                   const PrivateKeyContext& privateKey,
+                                   CrtMode mode, ThreadPool& pool, Workspace& workspace) {
+    const PrivateKeyContext::Material& key = *privateKey.material;
+    if (!key.engines.empty() && ciphertext.size() <= 8 * key.modulusLimbs) {
+        return DecryptNative(ciphertext, key.engines, key.exponentLimbs, key.partialLimbs, key.garnerLimbs,
+                             key.modulusLimbs, mode, pool);
+    }
+    BN_CTX* ctx = workspace.material->ctx.get();
+    BnFrame frame(ctx, true);
+    BIGNUM* c = frame.parse(ciphertext);
+    size_t count = key.primes.size();
+    BIGNUM* residues[MAX_PRIMES];
+    for (size_t i = 0; i < count; ++i) residues[i] = frame.get();
+
+    // residue_i = (c mod prime_i)^(d mod (prime_i - 1)) mod prime_i
+    auto exponentiate = [&](size_t i, BN_CTX* workCtx) {
+        // Tasks on other threads' workspaces scrub their own pools
+        BnFrame work(workCtx, workCtx != ctx);
+        BIGNUM* reduced = work.get();
+        if (!BN_mod(reduced, c, key.primes[i].get(), workCtx) ||
+            !BN_mod_exp_mont_consttime(residues[i], reduced, key.exponents[i].get(), key.primes[i].get(), workCtx,
+                                       key.monts[i].get())) {
+            throw std::runtime_error("M-RSA CRT exponentiation failed.");
+        }
+    };
+
+    if (mode == CrtMode::Parallel) {
+        // The key material is read-only, so the tasks share it and only need the
+        // workspace of the thread they land on
+        pool.runTasks(count, [&](size_t i) { exponentiate(i, Workspace::local().material->ctx.get()); });
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            exponentiate(i, ctx);
+        }
+    }
+
+    return key.recombine(residues, ctx);
+}
+
+std::vector<uint8_t> MRSA::PrivateKeyContext::Material::recombine(BIGNUM* const* residues, BN_CTX* ctx) const {
+    BnFrame frame(ctx);
+    BIGNUM* m = frame.get();
+    BIGNUM* digit = frame.get();
+    BIGNUM* term = frame.get();
+
+    // Garner: x = m_0, then x += ((m_i - x mod p_i) * garner_i mod p_i) * partials_i
+    if (!BN_copy(m, residues[0])) throw std::runtime_error("M-RSA CRT recombination failed.");
+    for (size_t i = 1; i < primes.size(); ++i) {
+        const BIGNUM* prime = primes[i].get();
+        if (!BN_mod(term, m, prime, ctx) ||
+            !BN_mod_sub_quick(digit, residues[i], term, prime) ||
+            !BN_mod_mul_montgomery(digit, digit, garner[i].get(), monts[i].get(), ctx) ||
+            !BN_mul(term, digit, partials[i].get(), ctx) ||
+            !BN_add(m, m, term)) {
+            throw std::runtime_error("M-RSA CRT recombination failed.");
+        }
+    }
+
+    std::vector<uint8_t> plaintext(BN_num_bytes(m));
+    BN_bn2bin(m, plaintext.data());
+    return plaintext;
+}
+
+void MRSA::PrivateKeyContext::Material::decryptLanes(const std::vector<uint8_t>* ciphertexts, size_t count,
+                                                     std::vector<uint8_t>* plaintexts, BN_CTX* ctx) const {
+    constexpr size_t LANES = MontLanes::LANES;
+    constexpr size_t WIDTH = MontContext::MAX_LIMBS;
+    size_t primeCount = primes.size();
+
+    // Reduce and recombine on the native engines when decrypt would, else on BIGNUMs
+    bool native = !engines.empty();
+    for (size_t l = 0; l < count; ++l) native = native && ciphertexts[l].size() <= 8 * modulusLimbs;
+
+    uint64_t c[LANES][MAX_MODULUS_LIMBS];
+    uint64_t bases[LANES][WIDTH];
+    uint64_t residues[LANES][MRSA::MAX_PRIMES][WIDTH] = {};
+    uint8_t bytes[WIDTH * 8];
+    BnFrame frame(ctx, true);
+    BIGNUM* values[LANES];
+    BIGNUM* reduced = native ? nullptr : frame.get();
+    for (size_t l = 0; l < count; ++l) {
+        if (native) {
+            MontContext::fromBytes(ciphertexts[l].data(), ciphertexts[l].size(), c[l], modulusLimbs);
+        } else {
+            values[l] = frame.parse(ciphertexts[l]);
+        }
+    }
+
+    for (size_t i = 0; i < primeCount; ++i) {
+        size_t width = lanes[i].width();
+        for (size_t l = 0; l < count; ++l) {
+            if (native) {
+                engines[i].reduce(c[l], modulusLimbs, bases[l]);
+            } else {
+                if (!BN_mod(reduced, values[l], primes[i].get(), ctx) ||
+                    BN_bn2binpad(reduced, bytes, static_cast<int>(width * 8)) < 0) {
+                    throw std::runtime_error("M-RSA CRT reduction failed.");
+                }
+                MontContext::fromBytes(bytes, width * 8, bases[l], width);
+            }
+        }
+        // Spare lanes repeat the first ciphertext; their results are dropped
+        for (size_t l = count; l < LANES; ++l) {
+            for (size_t j = 0; j < width; ++j) bases[l][j] = bases[0][j];
+        }
+
+        const uint64_t* in[LANES];
+        uint64_t* out[LANES];
+        for (size_t l = 0; l < LANES; ++l) {
+            in[l] = bases[l];
+            out[l] = residues[l][i];
+        }
+        lanes[i].modExp(in, laneExponents[i].data(), out);
+    }
+
+    for (size_t l = 0; l < count; ++l) {
+        if (native) {
+            plaintexts[l] = RecombineNative(residues[l], engines, partialLimbs, garnerLimbs, modulusLimbs);
+            continue;
+        }
+        BnFrame lane(ctx);
+        BIGNUM* parts[MRSA::MAX_PRIMES];
+        for (size_t i = 0; i < primeCount; ++i) {
+            size_t width = lanes[i].width();
+            MontContext::toBytes(residues[l][i], width, bytes, width * 8);
+            parts[i] = lane.parse(bytes, width * 8);
+        }
+        plaintexts[l] = recombine(parts, ctx);
+    }
+
+    OPENSSL_cleanse(c, sizeof(c));
+    OPENSSL_cleanse(bases, sizeof(bases));
+    OPENSSL_cleanse(residues, sizeof(residues));
+    OPENSSL_cleanse(bytes, sizeof(bytes));
+}
+
+std::vector<std::vector<uint8_t>> MRSA::decryptBatch(const std::vector<std::vector<uint8_t>>& ciphertexts,
+                                                     const PrivateKeyContext& privateKey,
+                                                     Workspace& workspace) {
+    const PrivateKeyContext::Material& key = *privateKey.material;
+    std::vector<std::vector<uint8_t>> plaintexts(ciphertexts.size());
+    size_t done = 0;
+    if (!key.lanes.empty()) {
+        while (ciphertexts.size() - done >= MIN_BATCH_LANES) {
+            size_t count = std::min(MontLanes::LANES, ciphertexts.size() - done);
+            key.decryptLanes(&ciphertexts[done], count, &plaintexts[done], workspace.material->ctx.get());
+            done += count;
+        }
+    }
+    for (; done < ciphertexts.size(); ++done) {
+        plaintexts[done] = decrypt(ciphertexts[done], privateKey, CrtMode::Sequential, ThreadPool::shared(), workspace);
+    }
+    return plaintexts;
+}
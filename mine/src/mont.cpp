@@ -0,0 +1,481 @@
+#include "mont.hpp"
+#include "utils.hpp"
+#include <stdexcept>
+#include <utility>
+
+#ifdef MONT_NATIVE
+
+using u128 = unsigned __int128;
+
+// Operand widths are compile-time constants, so the column loops unroll: completely up
+// to 12 limbs (primes of up to 768 bits), in blocks of 24 iterations beyond that to keep
+// code size and build time in check
+#define MONT_UNROLL _Pragma("GCC unroll 24")
+
+// All-ones if bit is 1, zero if 0
+static inline uint64_t MaskOf(uint64_t bit) {
+    return 0 - bit;
+}
+
+template <size_t N>
+static size_t BitLength(const std::array<uint64_t, N>& value) {
+    for (size_t i = N; i-- > 0;) {
+        if (value[i]) return 64 * i + 64 - __builtin_clzll(value[i]);
+    }
+    return 0;
+}
+
+template <size_t N>
+Mont<N>::Mont(const Limbs& modulus) : m(modulus), r1{}, r2{}, m0inv(0), bits(BitLength(modulus)) {
+    if (!(m[0] & 1) || bits < 2) throw std::invalid_argument("Montgomery modulus must be odd and above 1.");
+
+    // Newton iteration for m^-1 mod 2^64: each step doubles the number of correct bits
+    uint64_t inverse = m[0];
+    for (int i = 0; i < 5; ++i) inverse *= 2 - m[0] * inverse;
+    m0inv = 0 - inverse;
+
+    // R mod m and R^2 mod m by doubling 1 modulo m; only runs once per key
+    Limbs value{};
+    value[0] = 1;
+    for (size_t i = 0; i < 128 * N; ++i) {
+        add(value, value, value);
+        if (i + 1 == 64 * N) r1 = value;
+    }
+    r2 = value;
+}
+
+// acc += a * b on a three-word accumulator (low, high, overflow)
+static inline void MulAccumulate(u128& acc, uint64_t& overflow, uint64_t a, uint64_t b) {
+    u128 product = u128(a) * b;
+    acc += product;
+    overflow += acc < product;
+}
+
+// Shifts a column sum down one word, keeping the carry for the next column
+static inline void NextColumn(u128& acc, uint64_t& overflow) {
+    acc = (acc >> 64) | (u128(overflow) << 64);
+    overflow = 0;
+}
+
+// Final step of mul and sqr: result, with the top carry word, is below 2m
+template <size_t N>
+static inline void Normalize(const std::array<uint64_t, N>& m, const std::array<uint64_t, N>& result, uint64_t top,
+                             std::array<uint64_t, N>& out) {
+    // Subtract m unless that borrows past the top word
+    std::array<uint64_t, N> difference;
+    uint64_t borrow = 0;
+    for (size_t j = 0; j < N; ++j) {
+        u128 diff = u128(result[j]) - m[j] - borrow;
+        difference[j] = uint64_t(diff);
+        borrow = uint64_t(diff >> 64) & 1;
+    }
+    uint64_t keep = MaskOf(borrow & (top ^ 1));
+    for (size_t j = 0; j < N; ++j) out[j] = (result[j] & keep) | (difference[j] & ~keep);
+}
+
+template <size_t N>
+void Mont<N>::mul(const Limbs& a, const Limbs& b, Limbs& out) const {
+    // Finely integrated product scanning: column k of a * b and of q * m are summed
+    // together, and the low word of each of the first N columns picks q_k so that
+    // column clears. Columns N .. 2N-1 then hold a * b / R, below 2m.
+    uint64_t q[N];
+    Limbs result;
+    u128 acc = 0;
+    uint64_t overflow = 0;
+    MONT_UNROLL
+    for (size_t k = 0; k < N; ++k) {
+        MONT_UNROLL
+        for (size_t j = 0; j < k; ++j) {
+            MulAccumulate(acc, overflow, a[j], b[k - j]);
+            MulAccumulate(acc, overflow, q[j], m[k - j]);
+        }
+        MulAccumulate(acc, overflow, a[k], b[0]);
+        q[k] = uint64_t(acc) * m0inv;
+        MulAccumulate(acc, overflow, q[k], m[0]);
+        NextColumn(acc, overflow);
+    }
+    MONT_UNROLL
+    for (size_t k = N; k < 2 * N - 1; ++k) {
+        MONT_UNROLL
+        for (size_t j = k - N + 1; j < N; ++j) {
+            MulAccumulate(acc, overflow, a[j], b[k - j]);
+            MulAccumulate(acc, overflow, q[j], m[k - j]);
+        }
+        result[k - N] = uint64_t(acc);
+        NextColumn(acc, overflow);
+    }
+    result[N - 1] = uint64_t(acc);
+    Normalize<N>(m, result, uint64_t(acc >> 64), out);
+}
+
+template <size_t N>
+void Mont<N>::sqr(const Limbs& a, Limbs& out) const {
+    // As mul, but each cross product a_j * a_(k-j) is computed once and doubled
+    uint64_t q[N];
+    Limbs result;
+    u128 acc = 0;
+    uint64_t overflow = 0;
+    MONT_UNROLL
+    for (size_t k = 0; k < 2 * N - 1; ++k) {
+        u128 cross = 0;
+        uint64_t crossOverflow = 0;
+        size_t first = k < N ? 0 : k - N + 1;
+        MONT_UNROLL
+        for (size_t j = first; j < k - j; ++j) MulAccumulate(cross, crossOverflow, a[j], a[k - j]);
+        crossOverflow = crossOverflow << 1 | uint64_t(cross >> 127);
+        cross <<= 1;
+        if (k % 2 == 0) MulAccumulate(cross, crossOverflow, a[k / 2], a[k / 2]);
+        acc += cross;
+        overflow += crossOverflow + (acc < cross);
+
+        MONT_UNROLL
+        for (size_t j = first; j < (k < N ? k : N); ++j) MulAccumulate(acc, overflow, q[j], m[k - j]);
+        if (k < N) {
+            q[k] = uint64_t(acc) * m0inv;
+            MulAccumulate(acc, overflow, q[k], m[0]);
+        } else {
+            result[k - N] = uint64_t(acc);
+        }
+        NextColumn(acc, overflow);
+    }
+    result[N - 1] = uint64_t(acc);
+    Normalize<N>(m, result, uint64_t(acc >> 64), out);
+}
+
+template <size_t N>
+void Mont<N>::add(const Limbs& a, const Limbs& b, Limbs& out) const {
+    Limbs sum, difference;
+    uint64_t carry = 0;
+    for (size_t j = 0; j < N; ++j) {
+        u128 s = u128(a[j]) + b[j] + carry;
+        sum[j] = uint64_t(s);
+        carry = uint64_t(s >> 64);
+    }
+    uint64_t borrow = 0;
+    for (size_t j = 0; j < N; ++j) {
+        u128 diff = u128(sum[j]) - m[j] - borrow;
+        difference[j] = uint64_t(diff);
+        borrow = uint64_t(diff >> 64) & 1;
+    }
+    uint64_t keep = MaskOf(borrow & (carry ^ 1));
+    for (size_t j = 0; j < N; ++j) out[j] = (sum[j] & keep) | (difference[j] & ~keep);
+}
+
+template <size_t N>
+void Mont<N>::sub(const Limbs& a, const Limbs& b, Limbs& out) const {
+    Limbs difference;
+    uint64_t borrow = 0;
+    for (size_t j = 0; j < N; ++j) {
+        u128 diff = u128(a[j]) - b[j] - borrow;
+        difference[j] = uint64_t(diff);
+        borrow = uint64_t(diff >> 64) & 1;
+    }
+    // Add m back if it went negative
+    uint64_t mask = MaskOf(borrow);
+    uint64_t carry = 0;
+    for (size_t j = 0; j < N; ++j) {
+        u128 s = u128(difference[j]) + (m[j] & mask) + carry;
+        out[j] = uint64_t(s);
+        carry = uint64_t(s >> 64);
+    }
+}
+
+template <size_t N>
+void Mont<N>::fromMont(const Limbs& a, Limbs& out) const {
+    Limbs unit{};
+    unit[0] = 1;
+    mul(a, unit, out);
+}
+
+template <size_t N>
+void Mont<N>::reduceToMont(const uint64_t* value, size_t limbs, Limbs& out) const {
+    // Chunks c_j of N limbs: x = sum c_j R^j. With acc = (c_top .. c_(j+1)) * R mod m,
+    // mul(acc, R^2) shifts it up by one chunk and mul(c_j, R^2) = c_j * R mod m.
+    Limbs acc{};
+    Limbs chunk;
+    size_t chunks = (limbs + N - 1) / N;
+    for (size_t c = chunks; c-- > 0;) {
+        for (size_t j = 0; j < N; ++j) {
+            size_t index = c * N + j;
+            chunk[j] = index < limbs ? value[index] : 0;
+        }
+        mul(acc, r2, acc);
+        mul(chunk, r2, chunk);
+        add(acc, chunk, acc);
+    }
+    out = acc;
+}
+
+template <size_t N>
+void Mont<N>::pow(const Limbs& base, const Limbs& exponent, Limbs& out) const {
+    // 5-bit windows once the table's 32 entries are paid back by fewer multiplies
+    constexpr size_t WINDOW = N >= 12 ? 5 : 4;
+    constexpr size_t ENTRIES = size_t(1) << WINDOW;
+
+    Limbs table[ENTRIES];
+    table[0] = r1;
+    table[1] = base;
+    for (size_t k = 2; k < ENTRIES; ++k) mul(table[k - 1], base, table[k]);
+
+    auto windowAt = [&](size_t position) {
+        uint64_t value = 0;
+        for (size_t b = 0; b < WINDOW; ++b) {
+            size_t bit = position + b;
+            if (bit < 64 * N) value |= (exponent[bit / 64] >> (bit % 64) & 1) << b;
+        }
+        return value;
+    };
+    auto select = [&](uint64_t index, Limbs& entry) {
+        entry.fill(0);
+        for (size_t k = 0; k < ENTRIES; ++k) {
+            // All-ones exactly when k == index, computed without a branch
+            uint64_t mask = MaskOf(((uint64_t(k) ^ index) - 1) >> 63);
+            for (size_t j = 0; j < N; ++j) entry[j] |= table[k][j] & mask;
+        }
+    };
+
+    // The exponent is below m, so the modulus bit length bounds it without revealing it
+    size_t windows = (bits + WINDOW - 1) / WINDOW;
+    Limbs acc, entry;
+    select(windowAt((windows - 1) * WINDOW), acc);
+    for (size_t w = windows - 1; w-- > 0;) {
+        for (size_t s = 0; s < WINDOW; ++s) sqr(acc, acc);
+        select(windowAt(w * WINDOW), entry);
+        mul(acc, entry, acc);
+    }
+    out = acc;
+
+    Utils::secureZero(table, sizeof(table));
+    Utils::secureZero(entry.data(), sizeof(entry));
+}
+
+template <size_t N>
+void Mont<N>::powPublic(const Limbs& base, uint64_t exponent, Limbs& out) const {
+    if (exponent == 0) {
+        out = r1;
+        return;
+    }
+    Limbs acc = base;
+    for (int bit = 62 - __builtin_clzll(exponent); bit >= 0; --bit) {
+        sqr(acc, acc);
+        if (exponent >> bit & 1) mul(acc, base, acc);
+    }
+    out = acc;
+}
+
+// Widths compiled in: the prime sizes of the common key configurations, e.g. 6 limbs
+// for the 342-bit primes of a 1024-bit triple-prime key, 11 for 2048 bits, 22 for 4096,
+// and the power-of-two sizes up to a 2048-bit modulus
+template class Mont<2>;
+template class Mont<3>;
+template class Mont<4>;
+template class Mont<6>;
+template class Mont<8>;
+template class Mont<11>;
+template class Mont<12>;
+template class Mont<16>;
+template class Mont<22>;
+template class Mont<24>;
+template class Mont<32>;
+
+#endif
+
+struct MontContext::Engine {
+    virtual ~Engine() = default;
+    virtual size_t width() const = 0;
+    virtual void reduce(const uint64_t* value, size_t limbs, uint64_t* out) const = 0;
+    virtual void mulDifference(const uint64_t* a, const uint64_t* b, const uint64_t* factor, uint64_t* out) const = 0;
+    virtual void prepareFactor(const uint64_t* factor, uint64_t* out) const = 0;
+    virtual void modExp(const uint64_t* base, size_t baseLimbs, const uint64_t* exponent, uint64_t* out) const = 0;
+    virtual void modExpPublic(const uint64_t* base, size_t baseLimbs, uint64_t exponent, uint64_t* out) const = 0;
+};
+
+#ifdef MONT_NATIVE
+
+template <size_t N>
+struct FixedEngine final : MontContext::Engine {
+    using Limbs = typename Mont<N>::Limbs;
+    Mont<N> mont;
+
+    static Limbs Widen(const uint64_t* value, size_t limbs) {
+        Limbs result{};
+        for (size_t j = 0; j < limbs && j < N; ++j) result[j] = value[j];
+        return result;
+    }
+
+    static void Store(const Limbs& value, uint64_t* out) {
+        for (size_t j = 0; j < N; ++j) out[j] = value[j];
+    }
+
+    FixedEngine(const uint64_t* modulus, size_t limbs) : mont(Widen(modulus, limbs)) {}
+
+    size_t width() const override { return N; }
+
+    void reduce(const uint64_t* value, size_t limbs, uint64_t* out) const override {
+        Limbs result;
+        mont.reduceToMont(value, limbs, result);
+        mont.fromMont(result, result);
+        Store(result, out);
+    }
+
+    void mulDifference(const uint64_t* a, const uint64_t* b, const uint64_t* factor, uint64_t* out) const override {
+        Limbs difference;
+        mont.sub(Widen(a, N), Widen(b, N), difference);
+        mont.mul(difference, Widen(factor, N), difference);
+        Store(difference, out);
+    }
+
+    void prepareFactor(const uint64_t* factor, uint64_t* out) const override {
+        Limbs result;
+        mont.toMont(Widen(factor, N), result);
+        Store(result, out);
+    }
+
+    void modExp(const uint64_t* base, size_t baseLimbs, const uint64_t* exponent, uint64_t* out) const override {
+        Limbs value, power = Widen(exponent, N);
+        mont.reduceToMont(base, baseLimbs, value);
+        mont.pow(value, power, value);
+        mont.fromMont(value, value);
+        Store(value, out);
+        Utils::secureZero(power.data(), sizeof(power));
+    }
+
+    void modExpPublic(const uint64_t* base, size_t baseLimbs, uint64_t exponent, uint64_t* out) const override {
+        Limbs value;
+        mont.reduceToMont(base, baseLimbs, value);
+        mont.powPublic(value, exponent, value);
+        mont.fromMont(value, value);
+        Store(value, out);
+    }
+};
+
+template <size_t N>
+static std::unique_ptr<MontContext::Engine> MakeEngine(const uint64_t* modulus, size_t limbs) {
+    return std::make_unique<FixedEngine<N>>(modulus, limbs);
+}
+
+static constexpr size_t WIDTHS[] = { 2, 3, 4, 6, 8, 11, 12, 16, 22, 24, 32 };
+
+// Smallest compiled width that holds limbs, 0 if none
+static size_t WidthFor(size_t limbs) {
+    for (size_t candidate : WIDTHS) {
+        if (candidate >= limbs) return candidate;
+    }
+    return 0;
+}
+
+static std::unique_ptr<MontContext::Engine> EngineFor(const uint64_t* modulus, size_t limbs) {
+    switch (WidthFor(limbs)) {
+        case 2: return MakeEngine<2>(modulus, limbs);
+        case 3: return MakeEngine<3>(modulus, limbs);
+        case 4: return MakeEngine<4>(modulus, limbs);
+        case 6: return MakeEngine<6>(modulus, limbs);
+        case 8: return MakeEngine<8>(modulus, limbs);
+        case 11: return MakeEngine<11>(modulus, limbs);
+        case 12: return MakeEngine<12>(modulus, limbs);
+        case 16: return MakeEngine<16>(modulus, limbs);
+        case 22: return MakeEngine<22>(modulus, limbs);
+        case 24: return MakeEngine<24>(modulus, limbs);
+        case 32: return MakeEngine<32>(modulus, limbs);
+        default: throw std::invalid_argument("Montgomery modulus is too wide.");
+    }
+}
+
+bool MontContext::supports(size_t limbs) {
+    return limbs >= 1 && limbs <= MAX_LIMBS;
+}
+
+bool MontContext::preferred(size_t limbs) {
+    // A padded width does the work of the larger size, so only exact fits qualify
+    return supports(limbs) && WidthFor(limbs) == limbs && limbs % 8 != 0;
+}
+
+void MontContext::mulAdd(uint64_t* acc, size_t accLimbs, const uint64_t* a, size_t aLimbs, const uint64_t* b, size_t bLimbs) {
+    for (size_t i = 0; i < aLimbs; ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < bLimbs && i + j < accLimbs; ++j) {
+            u128 sum = u128(a[i]) * b[j] + acc[i + j] + carry;
+            acc[i + j] = uint64_t(sum);
+            carry = uint64_t(sum >> 64);
+        }
+        for (size_t k = i + bLimbs; k < accLimbs; ++k) {
+            u128 sum = u128(acc[k]) + carry;
+            acc[k] = uint64_t(sum);
+            carry = uint64_t(sum >> 64);
+        }
+    }
+}
+
+#else
+
+static std::unique_ptr<MontContext::Engine> EngineFor(const uint64_t*, size_t) {
+    throw std::invalid_argument("Fixed-width Montgomery arithmetic is not available on this compiler.");
+}
+
+bool MontContext::supports(size_t) {
+    return false;
+}
+
+bool MontContext::preferred(size_t) {
+    return false;
+}
+
+void MontContext::mulAdd(uint64_t*, size_t, const uint64_t*, size_t, const uint64_t*, size_t) {
+    throw std::logic_error("Fixed-width Montgomery arithmetic is not available on this compiler.");
+}
+
+#endif
+
+void MontContext::fromBytes(const uint8_t* bytes, size_t length, uint64_t* out, size_t limbs) {
+    for (size_t j = 0; j < limbs; ++j) out[j] = 0;
+    for (size_t i = 0; i < length; ++i) {
+        size_t position = length - 1 - i;  // byte significance, 0 = least
+        if (position / 8 >= limbs) {
+            if (bytes[i] != 0) throw std::invalid_argument("Value is wider than the limb buffer.");
+            continue;
+        }
+        out[position / 8] |= uint64_t(bytes[i]) << (8 * (position % 8));
+    }
+}
+
+void MontContext::toBytes(const uint64_t* value, size_t limbs, uint8_t* out, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        size_t position = length - 1 - i;
+        out[i] = position / 8 < limbs ? uint8_t(value[position / 8] >> (8 * (position % 8))) : 0;
+    }
+}
+
+MontContext::MontContext(const uint64_t* modulus, size_t limbs) {
+    // Leading zero limbs do not count towards the width
+    while (limbs > 0 && modulus[limbs - 1] == 0) --limbs;
+    if (!supports(limbs)) throw std::invalid_argument("Montgomery modulus is too wide.");
+    engine = EngineFor(modulus, limbs);
+}
+
+MontContext::~MontContext() = default;
+MontContext::MontContext(MontContext&& other) noexcept = default;
+MontContext& MontContext::operator=(MontContext&& other) noexcept = default;
+
+size_t MontContext::width() const {
+    return engine->width();
+}
+
+void MontContext::reduce(const uint64_t* value, size_t limbs, uint64_t* out) const {
+    engine->reduce(value, limbs, out);
+}
+
+void MontContext::mulDifference(const uint64_t* a, const uint64_t* b, const uint64_t* factor, uint64_t* out) const {
+    engine->mulDifference(a, b, factor, out);
+}
+
+void MontContext::prepareFactor(const uint64_t* factor, uint64_t* out) const {
+    engine->prepareFactor(factor, out);
+}
+
+void MontContext::modExp(const uint64_t* base, size_t baseLimbs, const uint64_t* exponent, uint64_t* out) const {
+    engine->modExp(base, baseLimbs, exponent, out);
+}
+
+void MontContext::modExpPublic(const uint64_t* base, size_t baseLimbs, uint64_t exponent, uint64_t* out) const {
+    engine->modExpPublic(base, baseLimbs, exponent, out);
+}
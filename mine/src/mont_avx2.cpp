@@ -0,0 +1,285 @@
+#include "mont.hpp"
+#include "cpu_features.hpp"
+#include "utils.hpp"
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define LANES_AVAILABLE 1
+#include <immintrin.h>
+#endif
+
+static constexpr unsigned DIGIT_BITS = 29;
+static constexpr uint64_t DIGIT_MASK = (uint64_t(1) << DIGIT_BITS) - 1;
+static constexpr size_t MAX_DIGITS = (64 * MontLanes::MAX_LIMBS + 2 + DIGIT_BITS - 1) / DIGIT_BITS;
+
+// value = 2 * value mod m, for value below m; only used while setting up a modulus
+static void DoubleMod(std::vector<uint64_t>& value, const uint64_t* m, size_t limbs) {
+    uint64_t carry = 0;
+    for (size_t j = 0; j < limbs; ++j) {
+        uint64_t next = value[j] >> 63;
+        value[j] = value[j] << 1 | carry;
+        carry = next;
+    }
+    std::vector<uint64_t> difference(limbs);
+    uint64_t borrow = 0;
+    for (size_t j = 0; j < limbs; ++j) {
+        uint64_t d = value[j] - m[j];
+        uint64_t below = value[j] < m[j];
+        difference[j] = d - borrow;
+        borrow = below | (d < borrow);
+    }
+    if (carry || !borrow) value = difference;
+}
+
+// Little-endian 64-bit limbs to 29-bit digits and back
+static void ToDigits(const uint64_t* value, size_t limbs, uint64_t* out, size_t digits) {
+    for (size_t j = 0; j < digits; ++j) {
+        size_t bit = j * DIGIT_BITS, word = bit / 64, offset = bit % 64;
+        uint64_t digit = word < limbs ? value[word] >> offset : 0;
+        if (offset > 64 - DIGIT_BITS && word + 1 < limbs) digit |= value[word + 1] << (64 - offset);
+        out[j] = digit & DIGIT_MASK;
+    }
+}
+
+static void FromDigits(const uint64_t* digits, size_t count, uint64_t* out, size_t limbs) {
+    for (size_t j = 0; j < limbs; ++j) out[j] = 0;
+    for (size_t j = 0; j < count; ++j) {
+        size_t bit = j * DIGIT_BITS, word = bit / 64, offset = bit % 64;
+        if (word < limbs) out[word] |= digits[j] << offset;
+        if (offset > 64 - DIGIT_BITS && word + 1 < limbs) out[word + 1] |= digits[j] >> (64 - offset);
+    }
+}
+
+MontLanes::MontLanes(const uint64_t* modulus, size_t count) : limbs(count), digits(0), bits(0), m0inv(0) {
+    if (!available()) throw std::runtime_error("AVX2 Montgomery lanes are not available on this CPU.");
+    while (limbs > 0 && modulus[limbs - 1] == 0) --limbs;
+    if (limbs == 0 || limbs > MAX_LIMBS) throw std::invalid_argument("Montgomery modulus is too wide.");
+    bits = 64 * (limbs - 1);
+    for (uint64_t top = modulus[limbs - 1]; top; top >>= 1) ++bits;
+    if (!(modulus[0] & 1) || bits < 2) throw std::invalid_argument("Montgomery modulus must be odd and above 1.");
+
+    // Two spare bits keep R above 4m, so products of operands below 2m stay below 2m and
+    // no lane ever needs a conditional subtraction until the final result
+    digits = (bits + 2 + DIGIT_BITS - 1) / DIGIT_BITS;
+
+    uint64_t inverse = modulus[0];
+    for (int i = 0; i < 5; ++i) inverse *= 2 - modulus[0] * inverse;
+    m0inv = (0 - inverse) & DIGIT_MASK;
+
+    m.resize(digits);
+    r1.resize(digits);
+    r2.resize(digits);
+    ToDigits(modulus, limbs, m.data(), digits);
+
+    std::vector<uint64_t> value(limbs, 0);
+    value[0] = 1;
+    for (size_t i = 0; i < 2 * DIGIT_BITS * digits; ++i) {
+        DoubleMod(value, modulus, limbs);
+        if (i + 1 == DIGIT_BITS * digits) ToDigits(value.data(), limbs, r1.data(), digits);
+    }
+    ToDigits(value.data(), limbs, r2.data(), digits);
+}
+
+bool MontLanes::supports(size_t limbs) {
+    return available() && limbs >= 1 && limbs <= MAX_LIMBS;
+}
+
+bool MontLanes::preferred(size_t limbs) {
+    return supports(limbs) && limbs >= 4 && limbs % 8 != 0;
+}
+
+#ifdef LANES_AVAILABLE
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+// Each row adds two products below 2^58 to every column, so 31 rows fit in 64 bits;
+// moduli wider than that take a carry pass every CARRY_INTERVAL rows
+static constexpr size_t CARRY_INTERVAL = 31;
+
+#define LANES_UNROLL _Pragma("GCC unroll 72")
+
+#if defined(__GNUC__)
+__attribute__((always_inline))
+#endif
+static inline void Carry(const __m256i* in, __m256i* out, size_t digits) {
+    const __m256i mask = _mm256_set1_epi64x(DIGIT_MASK);
+    __m256i carry = _mm256_setzero_si256();
+    for (size_t j = 0; j < digits; ++j) {
+        __m256i value = _mm256_add_epi64(in[j], carry);
+        out[j] = _mm256_and_si256(value, mask);
+        carry = _mm256_srli_epi64(value, DIGIT_BITS);
+    }
+}
+
+// Shared body of the fixed and generic multiplies below; inlined into each, so with a
+// constant digit count the row loop unrolls and the accumulators can stay in registers
+#if defined(__GNUC__)
+__attribute__((always_inline))
+#endif
+static inline void MulRows(const __m256i* a, const __m256i* b, __m256i* out, const __m256i* m, __m256i m0inv,
+                           size_t digits, __m256i* acc) {
+    const __m256i mask = _mm256_set1_epi64x(DIGIT_MASK);
+    for (size_t j = 0; j < digits; ++j) acc[j] = _mm256_setzero_si256();
+
+    for (size_t i = 0; i < digits; ++i) {
+        __m256i ai = a[i];
+        __m256i low = _mm256_add_epi64(acc[0], _mm256_mul_epu32(ai, b[0]));
+        __m256i q = _mm256_and_si256(_mm256_mul_epu32(low, m0inv), mask);
+        low = _mm256_add_epi64(low, _mm256_mul_epu32(q, m[0]));
+        __m256i carry = _mm256_srli_epi64(low, DIGIT_BITS);
+        // The low digit is now zero; shift the row down one digit as it is accumulated
+        LANES_UNROLL
+        for (size_t j = 1; j < digits; ++j) {
+            __m256i products = _mm256_add_epi64(_mm256_mul_epu32(ai, b[j]), _mm256_mul_epu32(q, m[j]));
+            acc[j - 1] = _mm256_add_epi64(acc[j], products);
+        }
+        acc[digits - 1] = _mm256_setzero_si256();
+        acc[0] = _mm256_add_epi64(acc[0], carry);
+        if (digits > CARRY_INTERVAL && (i + 1) % CARRY_INTERVAL == 0) Carry(acc, acc, digits);
+    }
+    Carry(acc, out, digits);
+}
+
+template <size_t D>
+static void MulFixed(const __m256i* a, const __m256i* b, __m256i* out, const __m256i* m, __m256i m0inv) {
+    __m256i acc[D];
+    MulRows(a, b, out, m, m0inv, D, acc);
+}
+
+static void MulGeneric(const __m256i* a, const __m256i* b, __m256i* out, const __m256i* m, __m256i m0inv, size_t digits) {
+    __m256i acc[MAX_DIGITS];
+    MulRows(a, b, out, m, m0inv, digits, acc);
+}
+
+// out = a * b / R mod m in every lane, operand-scanning with the reduction folded into
+// each row. Inputs below 2m with digits below 2^29; the output is the same. out may
+// alias either input. The fixed widths are the primes of the key sizes generateKey is
+// used with: 256, 341-342, 512, 682-683, 1024, 1365-1366, 1536, 1638-1639 and 2048 bits.
+static void MulLanes(const __m256i* a, const __m256i* b, __m256i* out, const __m256i* m, __m256i m0inv, size_t digits) {
+    switch (digits) {
+        case 9: return MulFixed<9>(a, b, out, m, m0inv);
+        case 12: return MulFixed<12>(a, b, out, m, m0inv);
+        case 18: return MulFixed<18>(a, b, out, m, m0inv);
+        case 24: return MulFixed<24>(a, b, out, m, m0inv);
+        case 36: return MulFixed<36>(a, b, out, m, m0inv);
+        case 48: return MulFixed<48>(a, b, out, m, m0inv);
+        case 54: return MulFixed<54>(a, b, out, m, m0inv);
+        case 57: return MulFixed<57>(a, b, out, m, m0inv);
+        case 71: return MulFixed<71>(a, b, out, m, m0inv);
+        default: return MulGeneric(a, b, out, m, m0inv, digits);
+    }
+}
+
+static void PowLanes(const uint64_t* const bases[MontLanes::LANES], const uint64_t* exponent,
+                     uint64_t* const out[MontLanes::LANES], const uint64_t* modulus, const uint64_t* one,
+                     const uint64_t* square, uint64_t inverse, size_t limbs, size_t digits, size_t bits) {
+    constexpr size_t LANES = MontLanes::LANES;
+    const size_t WINDOW = bits > 512 ? 5 : 4;
+    const size_t ENTRIES = size_t(1) << WINDOW;
+
+    __m256i m[MAX_DIGITS], r2[MAX_DIGITS], acc[MAX_DIGITS], entry[MAX_DIGITS];
+    uint64_t staging[LANES][MAX_DIGITS];
+    for (size_t j = 0; j < digits; ++j) {
+        m[j] = _mm256_set1_epi64x(static_cast<long long>(modulus[j]));
+        r2[j] = _mm256_set1_epi64x(static_cast<long long>(square[j]));
+    }
+    const __m256i m0inv = _mm256_set1_epi64x(static_cast<long long>(inverse));
+
+    // Lane l of digit j holds digit j of base l
+    for (size_t l = 0; l < LANES; ++l) ToDigits(bases[l], limbs, staging[l], digits);
+    __m256i table[32 * MAX_DIGITS];  // up to 2^5 entries; about 72 KB at the widest modulus
+    __m256i* base = &table[digits];
+    for (size_t j = 0; j < digits; ++j) {
+        base[j] = _mm256_set_epi64x(static_cast<long long>(staging[3][j]), static_cast<long long>(staging[2][j]),
+                                    static_cast<long long>(staging[1][j]), static_cast<long long>(staging[0][j]));
+        table[j] = _mm256_set1_epi64x(static_cast<long long>(one[j]));
+    }
+    MulLanes(base, r2, base, m, m0inv, digits);
+    for (size_t k = 2; k < ENTRIES; ++k) MulLanes(&table[(k - 1) * digits], base, &table[k * digits], m, m0inv, digits);
+
+    auto windowAt = [&](size_t position) {
+        uint64_t value = 0;
+        for (size_t b = 0; b < WINDOW; ++b) {
+            size_t bit = position + b;
+            if (bit < 64 * limbs) value |= (exponent[bit / 64] >> (bit % 64) & 1) << b;
+        }
+        return value;
+    };
+    // Every entry is read whatever the index, as in Mont<N>::pow
+    auto select = [&](uint64_t index, __m256i* target) {
+        for (size_t j = 0; j < digits; ++j) target[j] = _mm256_setzero_si256();
+        for (size_t k = 0; k < ENTRIES; ++k) {
+            __m256i mask = _mm256_set1_epi64x(-static_cast<long long>(((uint64_t(k) ^ index) - 1) >> 63));
+            const __m256i* candidate = &table[k * digits];
+            for (size_t j = 0; j < digits; ++j) target[j] = _mm256_or_si256(target[j], _mm256_and_si256(candidate[j], mask));
+        }
+    };
+
+    size_t windows = (bits + WINDOW - 1) / WINDOW;
+    select(windowAt((windows - 1) * WINDOW), acc);
+    for (size_t w = windows - 1; w-- > 0;) {
+        for (size_t s = 0; s < WINDOW; ++s) MulLanes(acc, acc, acc, m, m0inv, digits);
+        select(windowAt(w * WINDOW), entry);
+        MulLanes(acc, entry, acc, m, m0inv, digits);
+    }
+
+    // Out of Montgomery form: multiplying by 1 leaves a value of at most m, which equals
+    // m only for a zero base, so one masked subtraction finishes the reduction
+    for (size_t j = 0; j < digits; ++j) entry[j] = _mm256_setzero_si256();
+    entry[0] = _mm256_set1_epi64x(1);
+    MulLanes(acc, entry, acc, m, m0inv, digits);
+    const __m256i mask = _mm256_set1_epi64x(DIGIT_MASK);
+    __m256i borrow = _mm256_setzero_si256();
+    for (size_t j = 0; j < digits; ++j) {
+        __m256i difference = _mm256_sub_epi64(_mm256_sub_epi64(acc[j], m[j]), borrow);
+        entry[j] = _mm256_and_si256(difference, mask);
+        borrow = _mm256_srli_epi64(difference, 63);
+    }
+    __m256i keep = _mm256_cmpeq_epi64(borrow, _mm256_setzero_si256());
+    for (size_t j = 0; j < digits; ++j) {
+        acc[j] = _mm256_blendv_epi8(acc[j], entry[j], keep);
+    }
+
+    for (size_t j = 0; j < digits; ++j) {
+        alignas(32) uint64_t lanes[LANES];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc[j]);
+        for (size_t l = 0; l < LANES; ++l) staging[l][j] = lanes[l];
+    }
+    for (size_t l = 0; l < LANES; ++l) FromDigits(staging[l], digits, out[l], limbs);
+
+    Utils::secureZero(table, ENTRIES * digits * sizeof(__m256i));
+    Utils::secureZero(acc, sizeof(acc));
+    Utils::secureZero(entry, sizeof(entry));
+    Utils::secureZero(staging, sizeof(staging));
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+bool MontLanes::available() {
+    return CpuFeatures::Detect().avx2;
+}
+
+void MontLanes::modExp(const uint64_t* const bases[LANES], const uint64_t* exponent, uint64_t* const out[LANES]) const {
+    PowLanes(bases, exponent, out, m.data(), r1.data(), r2.data(), m0inv, limbs, digits, bits);
+}
+
+#else
+
+bool MontLanes::available() {
+    return false;
+}
+
+void MontLanes::modExp(const uint64_t* const*, const uint64_t*, uint64_t* const*) const {
+    throw std::runtime_error("AVX2 Montgomery lanes are not available on this architecture.");
+}
+
+#endif
@@ -0,0 +1,245 @@
+#include "numa.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#define NUMA_LINUX 1
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Numa {
+
+static constexpr size_t PAGE_ALIGNMENT = 4096;
+
+std::vector<unsigned int> ParseCpuList(const std::string& list) {
+    std::vector<unsigned int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string item = list.substr(pos, end - pos);
+        while (!item.empty() && (item.back() == '\n' || item.back() == ' ')) item.pop_back();
+        pos = end + 1;
+        if (item.empty()) continue;
+
+        size_t dash = item.find('-');
+        char* tail = nullptr;
+        unsigned long first = std::strtoul(item.c_str(), &tail, 10);
+        unsigned long last = first;
+        if (dash != std::string::npos) {
+            if (tail != item.c_str() + dash) throw std::invalid_argument("Malformed CPU list: " + list);
+            last = std::strtoul(item.c_str() + dash + 1, &tail, 10);
+        }
+        if (tail == item.c_str() || *tail != '\0' || last < first) throw std::invalid_argument("Malformed CPU list: " + list);
+        for (unsigned long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<unsigned int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+static Topology SingleNode() {
+    Topology topology;
+    unsigned int cores = std::thread::hardware_concurrency();
+    if (cores == 0) cores = 1;
+    topology.nodeCpus.resize(1);
+    for (unsigned int cpu = 0; cpu < cores; ++cpu) {
+        topology.nodeCpus[0].push_back(cpu);
+        topology.cpuNode.push_back(0);
+    }
+    return topology;
+}
+
+static Topology Query() {
+#ifdef NUMA_LINUX
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (!dir) return SingleNode();
+
+    Topology topology;
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0) continue;
+        char* tail = nullptr;
+        unsigned long node = std::strtoul(name.c_str() + 4, &tail, 10);
+        if (*tail != '\0') continue;
+
+        std::ifstream file("/sys/devices/system/node/" + name + "/cpulist");
+        std::string list;
+        if (!file || !std::getline(file, list)) continue;
+
+        // Node ids can be sparse, and memory-only nodes have an empty list
+        if (topology.nodeCpus.size() <= node) topology.nodeCpus.resize(node + 1);
+        topology.nodeCpus[node] = ParseCpuList(list);
+        for (unsigned int cpu : topology.nodeCpus[node]) {
+            if (topology.cpuNode.size() <= cpu) topology.cpuNode.resize(cpu + 1, -1);
+            topology.cpuNode[cpu] = static_cast<int>(node);
+        }
+    }
+    closedir(dir);
+
+    size_t populated = 0;
+    for (const auto& cpus : topology.nodeCpus) {
+        if (!cpus.empty()) ++populated;
+    }
+    if (populated == 0) return SingleNode();
+    if (populated == 1) {
+        // A single node: report it as node 0 so callers need not special-case its id
+        Topology single;
+        for (auto& cpus : topology.nodeCpus) {
+            if (!cpus.empty()) single.nodeCpus.push_back(std::move(cpus));
+        }
+        single.cpuNode.assign(topology.cpuNode.size(), -1);
+        for (unsigned int cpu : single.nodeCpus[0]) single.cpuNode[cpu] = 0;
+        return single;
+    }
+    return topology;
+#else
+    return SingleNode();
+#endif
+}
+
+const Topology& Detect() {
+    static const Topology topology = Query();
+    return topology;
+}
+
+int NodeOfCpu(unsigned int cpu) {
+    const Topology& topology = Detect();
+    return cpu < topology.cpuNode.size() ? topology.cpuNode[cpu] : -1;
+}
+
+int NodeOfAddress(const void* address) {
+    if (!Detect().multiNode()) return 0;
+#ifdef NUMA_LINUX
+    // move_pages with no target nodes only reports where each page currently lives
+    void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(address) & ~uintptr_t(PAGE_ALIGNMENT - 1));
+    int status = -1;
+    if (syscall(SYS_move_pages, 0, 1UL, &page, nullptr, &status, 0) != 0) return -1;
+    return status >= 0 ? status : -1;
+#else
+    (void)address;
+    return -1;
+#endif
+}
+
+bool PinCurrentThread(unsigned int cpu) {
+#ifdef NUMA_LINUX
+    if (cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+#ifdef NUMA_LINUX
+// From <linux/mempolicy.h>, which is not always installed
+static constexpr int MPOL_PREFERRED_MODE = 1;
+static constexpr int MPOL_INTERLEAVE_MODE = 3;
+
+static void* MapPages(size_t bytes) {
+    void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) throw std::bad_alloc();
+    return data;
+}
+
+// Advisory: a failed mbind leaves the default first-touch policy in place
+static void ApplyPolicy(void* data, size_t bytes, int mode, const std::vector<unsigned long>& mask) {
+    syscall(SYS_mbind, data, bytes, mode, mask.data(), mask.size() * 8 * sizeof(unsigned long) + 1, 0);
+}
+
+static void SetNode(std::vector<unsigned long>& mask, size_t node) {
+    size_t bits = 8 * sizeof(unsigned long);
+    if (mask.size() <= node / bits) mask.resize(node / bits + 1, 0);
+    mask[node / bits] |= 1UL << (node % bits);
+}
+#endif
+
+void* Allocate(size_t bytes, int node) {
+    if (bytes == 0) return nullptr;
+#ifdef NUMA_LINUX
+    void* data = MapPages(bytes);
+    const Topology& topology = Detect();
+    if (topology.multiNode() && node >= 0 && static_cast<size_t>(node) < topology.nodeCount()) {
+        std::vector<unsigned long> mask;
+        SetNode(mask, static_cast<size_t>(node));
+        ApplyPolicy(data, bytes, MPOL_PREFERRED_MODE, mask);
+    }
+    return data;
+#else
+    (void)node;
+    return ::operator new(bytes, std::align_val_t(PAGE_ALIGNMENT));
+#endif
+}
+
+void* AllocateInterleaved(size_t bytes) {
+    if (bytes == 0) return nullptr;
+#ifdef NUMA_LINUX
+    void* data = MapPages(bytes);
+    const Topology& topology = Detect();
+    if (topology.multiNode()) {
+        std::vector<unsigned long> mask;
+        for (size_t node = 0; node < topology.nodeCount(); ++node) {
+            if (!topology.nodeCpus[node].empty()) SetNode(mask, node);
+        }
+        ApplyPolicy(data, bytes, MPOL_INTERLEAVE_MODE, mask);
+    }
+    return data;
+#else
+    return ::operator new(bytes, std::align_val_t(PAGE_ALIGNMENT));
+#endif
+}
+
+void Free(void* data, size_t bytes) {
+    if (!data) return;
+#ifdef NUMA_LINUX
+    munmap(data, bytes);
+#else
+    (void)bytes;
+    ::operator delete(data, std::align_val_t(PAGE_ALIGNMENT));
+#endif
+}
+
+Buffer::Buffer(size_t size, int node) : bytes(static_cast<unsigned char*>(Allocate(size, node))), length(size) {}
+
+Buffer Buffer::Interleaved(size_t size) {
+    Buffer buffer;
+    buffer.bytes = static_cast<unsigned char*>(AllocateInterleaved(size));
+    buffer.length = size;
+    return buffer;
+}
+
+Buffer::~Buffer() {
+    Free(bytes, length);
+}
+
+Buffer::Buffer(Buffer&& other) noexcept : bytes(other.bytes), length(other.length) {
+    other.bytes = nullptr;
+    other.length = 0;
+}
+
+Buffer& Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        Free(bytes, length);
+        bytes = other.bytes;
+        length = other.length;
+        other.bytes = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+} // namespace Numa
@@ -1,134 +1,642 @@
 #include "s_aes.hpp"
 #include "aes_core.hpp"
-#include <thread>
+#include "autotune.hpp"
+#include "ghash.hpp"
+#include "numa.hpp"
+#include "utils.hpp"
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <stdexcept>
 
-SAES::SAES(const std::vector<uint8_t>& key) {
-    expandedKey = AESCore::ExpandKey(key, ROUNDS);
+template <int Rounds>
+SAES<Rounds>::SAES(const std::vector<uint8_t>& key, ThreadPool& threadPool) : pool(&threadPool) {
+    AESCore::ExpandKey(key.data(), key.size(), Rounds, expandedKey.data());
+    AESCore::InvertKeySchedule(expandedKey.data(), Rounds, decryptionKey.data());
+    kernel = &AESCore::ActiveKernel<Rounds>();
+    tuningParams = &Autotune::ForKernel(*kernel, threadPool);
 }
 
-void SAES::encryptBlock(const uint8_t* input, uint8_t* output) const {
-    AESCore::State state;
-    std::memcpy(state.data(), input, 16);
-    
-    AESCore::AddRoundKey(state, expandedKey.data());
+// Out of line so s_aes.hpp only needs the forward declaration of Autotune::Params
+template <int Rounds>
+const Autotune::Params& SAES<Rounds>::tuning() const {
+    return *tuningParams;
+}
+
+template <int Rounds>
+void SAES<Rounds>::encryptBlock(const uint8_t* input, uint8_t* output) const {
+    kernel->encryptBlock(expandedKey.data(), input, output);
+}
+
+template <int Rounds>
+void SAES<Rounds>::decryptBlock(const uint8_t* input, uint8_t* output) const {
+    kernel->decryptBlock(decryptionKey.data(), input, output);
+}
+
+template <int Rounds>
+std::vector<uint8_t> SAES<Rounds>::encrypt(const std::vector<uint8_t>& plaintext, const std::vector<uint8_t>& iv) {
+    std::vector<uint8_t> output(plaintext.size());
+    processBlocksParallel(plaintext.data(), plaintext.size(), iv.data(), 0, output.data());
+    return output;
+}
+
+template <int Rounds>
+std::vector<uint8_t> SAES<Rounds>::decrypt(const std::vector<uint8_t>& ciphertext, const std::vector<uint8_t>& iv) {
+    std::vector<uint8_t> output(ciphertext.size());
+    processBlocksParallel(ciphertext.data(), ciphertext.size(), iv.data(), 0, output.data());
+    return output;
+}
+
+template <int Rounds>
+void SAES<Rounds>::encrypt(const uint8_t* input, size_t length, const uint8_t* iv, uint8_t* output) {
+    processBlocksParallel(input, length, iv, 0, output);
+}
+
+template <int Rounds>
+void SAES<Rounds>::decrypt(const uint8_t* input, size_t length, const uint8_t* iv, uint8_t* output) {
+    processBlocksParallel(input, length, iv, 0, output);
+}
+
+template <int Rounds>
+void SAES<Rounds>::encryptBlocks(const uint8_t* ctrs, uint8_t* out, size_t n) const {
+    kernel->encryptBlocks(expandedKey.data(), ctrs, out, n);
+}
 
-    for (int round = 1; round < ROUNDS; ++round) {
-        AESCore::SubBytes(state);
-        AESCore::ShiftRows(state);
-        AESCore::MixColumns(state);
-        AESCore::AddRoundKey(state, expandedKey.data() + (round * 16));
+static inline uint64_t LoadBE64(const uint8_t* p) {
+    return (uint64_t(p[0]) << 56) | (uint64_t(p[1]) << 48) | (uint64_t(p[2]) << 40) | (uint64_t(p[3]) << 32) |
+           (uint64_t(p[4]) << 24) | (uint64_t(p[5]) << 16) | (uint64_t(p[6]) << 8) | uint64_t(p[7]);
+}
+
+static inline void StoreBE64(uint8_t* p, uint64_t v) {
+    p[0] = static_cast<uint8_t>(v >> 56);
+    p[1] = static_cast<uint8_t>(v >> 48);
+    p[2] = static_cast<uint8_t>(v >> 40);
+    p[3] = static_cast<uint8_t>(v >> 32);
+    p[4] = static_cast<uint8_t>(v >> 24);
+    p[5] = static_cast<uint8_t>(v >> 16);
+    p[6] = static_cast<uint8_t>(v >> 8);
+    p[7] = static_cast<uint8_t>(v);
+}
+
+static inline uint32_t LoadBE32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static inline void StoreBE32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+// out = in ^ keystream, a machine word at a time. out may alias in.
+static inline void XorKeystream(uint8_t* out, const uint8_t* in, const uint8_t* keystream, size_t length) {
+    size_t k = 0;
+    for (; k + 8 <= length; k += 8) {
+        uint64_t a, b;
+        std::memcpy(&a, in + k, 8);
+        std::memcpy(&b, keystream + k, 8);
+        a ^= b;
+        std::memcpy(out + k, &a, 8);
+    }
+    for (; k < length; ++k) {
+        out[k] = in[k] ^ keystream[k];
     }
+}
+
+template <int Rounds>
+void SAES<Rounds>::ctrXor(const uint8_t* iv, uint64_t startBlock, const uint8_t* input, uint8_t* output, size_t length) const {
+    // Counter = IV + block index as a 128-bit big-endian integer
+    uint64_t hi = LoadBE64(iv);
+    uint64_t lo = LoadBE64(iv + 8);
+    uint64_t startLo = lo + startBlock;
+    if (startLo < lo) ++hi;
+    lo = startLo;
+
+    uint8_t counters[CTR_BATCH * 16];
+    uint8_t keystream[CTR_BATCH * 16];
 
-    AESCore::SubBytes(state);
-    AESCore::ShiftRows(state);
-    AESCore::AddRoundKey(state, expandedKey.data() + (ROUNDS * 16));
-    
-    std::memcpy(output, state.data(), 16);
+    size_t offset = 0;
+    while (offset < length) {
+        size_t remaining = length - offset;
+        size_t batchBytes = remaining < sizeof(keystream) ? remaining : sizeof(keystream);
+        size_t batchBlocks = (batchBytes + 15) / 16;
+
+        for (size_t b = 0; b < batchBlocks; ++b) {
+            StoreBE64(counters + (b * 16), hi);
+            StoreBE64(counters + (b * 16) + 8, lo);
+            if (++lo == 0) ++hi;
+        }
+
+        encryptBlocks(counters, keystream, batchBlocks);
+        XorKeystream(output + offset, input + offset, keystream, batchBytes);
+        offset += batchBytes;
+    }
 }
 
-void SAES::decryptBlock(const uint8_t* input, uint8_t* output) const {
-    AESCore::State state;
-    std::memcpy(state.data(), input, 16);
+template <int Rounds>
+void SAES<Rounds>::processBlocksParallel(const uint8_t* input, size_t length, const uint8_t* iv, uint64_t startBlock, uint8_t* output) {
+    if (length == 0) return;
 
-    AESCore::AddRoundKey(state, expandedKey.data() + (ROUNDS * 16));
+    size_t numBlocks = (length + 15) / 16;
 
-    for (int round = ROUNDS - 1; round > 0; --round) {
-        AESCore::InvShiftRows(state);
-        AESCore::InvSubBytes(state);
-        AESCore::AddRoundKey(state, expandedKey.data() + (round * 16));
-        AESCore::InvMixColumns(state);
+    // Short messages stay on the caller; longer ones get one range per task that pays off
+    size_t tasks = Autotune::TaskCount(*tuningParams, numBlocks, pool->concurrency());
+    if (tasks <= 1) {
+        ctrXor(iv, startBlock, input, output, length);
+        return;
     }
 
-    AESCore::InvShiftRows(state);
-    AESCore::InvSubBytes(state);
-    AESCore::AddRoundKey(state, expandedKey.data());
+    // Ranges are disjoint, so in-place operation is safe across tasks
+    auto range = [&](size_t beginBlock, size_t endBlock) {
+        size_t startByte = beginBlock * 16;
+        size_t endByte = endBlock * 16 < length ? endBlock * 16 : length;
+        ctrXor(iv, startBlock + beginBlock, input + startByte, output + startByte, endByte - startByte);
+    };
+    if (!pool->nodeAware()) {
+        pool->parallelFor(numBlocks, (numBlocks + tasks - 1) / tasks, range);
+        return;
+    }
 
-    std::memcpy(output, state.data(), 16);
+    // On multi-node machines each range runs on the node holding the start of its input
+    pool->parallelFor(numBlocks, (numBlocks + tasks - 1) / tasks, range,
+                      [&](size_t beginBlock) { return Numa::NodeOfAddress(input + (beginBlock * 16)); });
 }
 
-std::vector<uint8_t> SAES::encrypt(const std::vector<uint8_t>& plaintext, const std::vector<uint8_t>& iv) {
-    std::vector<uint8_t> output(plaintext.size());
-    processBlocksParallel(plaintext, output, iv);
-    return output;
+template <int Rounds>
+SAES<Rounds>::KeySchedule::KeySchedule(const uint8_t* key, size_t keyLength) {
+    AESCore::ExpandKey(key, keyLength, Rounds, roundKeys.data());
 }
 
-std::vector<uint8_t> SAES::decrypt(const std::vector<uint8_t>& ciphertext, const std::vector<uint8_t>& iv) {
-    std::vector<uint8_t> output(ciphertext.size());
-    processBlocksParallel(ciphertext, output, iv);
-    return output;
+template <int Rounds>
+SAES<Rounds>::KeySchedule::KeySchedule(const std::vector<uint8_t>& key) : KeySchedule(key.data(), key.size()) {}
+
+template <int Rounds>
+SAES<Rounds>::KeySchedule::~KeySchedule() {
+    Utils::secureZero(roundKeys.data(), roundKeys.size());
 }
 
-void SAES::processBlocksParallel(const std::vector<uint8_t>& input, std::vector<uint8_t>& output, const std::vector<uint8_t>& iv) {
-    if (input.empty()) return;
-
-    size_t numBlocks = (input.size() + 15) / 16;
-    unsigned int numThreads = std::thread::hardware_concurrency();
-    if (numThreads == 0) numThreads = 4;
-    if (numThreads > numBlocks) numThreads = numBlocks;
-
-    auto processChunk = [&](size_t startBlock, size_t endBlock) {
-        for (size_t i = startBlock; i < endBlock; ++i) {
-            uint8_t counter[16];
-            std::memcpy(counter, iv.data(), 16);
-            
-            uint64_t carry = i;
-            for (int j = 15; j >= 0 && carry > 0; --j) {
-                carry += counter[j];
-                counter[j] = carry & 0xFF;
-                carry >>= 8;
+template <int Rounds>
+void SAES<Rounds>::batchXor(const AESCore::BlockKernel<Rounds>& kernel, const BatchJob* jobs, size_t count,
+                            size_t job, size_t offset, size_t numBlocks) {
+    alignas(16) uint8_t counters[CTR_BATCH * 16];
+    alignas(16) uint8_t keystream[CTR_BATCH * 16];
+    const uint8_t* keys[CTR_BATCH];
+
+    while (numBlocks > 0) {
+        // Fill the batch with counter blocks, spilling from one message into the next
+        size_t n = 0;
+        size_t fillJob = job;
+        size_t fillOffset = offset;
+        while (n < CTR_BATCH && n < numBlocks && fillJob < count) {
+            const BatchJob& current = jobs[fillJob];
+            if (fillOffset >= current.length) {
+                ++fillJob;
+                fillOffset = 0;
+                continue;
             }
 
-            uint8_t keystream[16];
-            encryptBlock(counter, keystream);
-
-            size_t inOffset = i * 16;
-            size_t remaining = input.size() - inOffset;
-            size_t bytesToProcess = remaining < 16 ? remaining : 16;
-
-            const uint8_t* inPtr = input.data() + inOffset;
-            uint8_t* outPtr = output.data() + inOffset;
-
-            if (bytesToProcess == 16) {
-                outPtr[0] = inPtr[0] ^ keystream[0];
-                outPtr[1] = inPtr[1] ^ keystream[1];
-                outPtr[2] = inPtr[2] ^ keystream[2];
-                outPtr[3] = inPtr[3] ^ keystream[3];
-                outPtr[4] = inPtr[4] ^ keystream[4];
-                outPtr[5] = inPtr[5] ^ keystream[5];
-                outPtr[6] = inPtr[6] ^ keystream[6];
-                outPtr[7] = inPtr[7] ^ keystream[7];
-                outPtr[8] = inPtr[8] ^ keystream[8];
-                outPtr[9] = inPtr[9] ^ keystream[9];
-                outPtr[10] = inPtr[10] ^ keystream[10];
-                outPtr[11] = inPtr[11] ^ keystream[11];
-                outPtr[12] = inPtr[12] ^ keystream[12];
-                outPtr[13] = inPtr[13] ^ keystream[13];
-                outPtr[14] = inPtr[14] ^ keystream[14];
-                outPtr[15] = inPtr[15] ^ keystream[15];
-            } else {
-                for (size_t k = 0; k < bytesToProcess; ++k) {
-                    outPtr[k] = inPtr[k] ^ keystream[k];
-                }
+            uint64_t hi = LoadBE64(current.iv);
+            uint64_t lo = LoadBE64(current.iv + 8);
+            uint64_t startLo = lo + fillOffset / 16;
+            if (startLo < lo) ++hi;
+            lo = startLo;
+
+            for (; n < CTR_BATCH && n < numBlocks && fillOffset < current.length; ++n, fillOffset += 16) {
+                StoreBE64(counters + (n * 16), hi);
+                StoreBE64(counters + (n * 16) + 8, lo);
+                if (++lo == 0) ++hi;
+                keys[n] = current.key->roundKeys.data();
             }
         }
-    };
+        if (n == 0) return;
+
+        kernel.encryptBlocksMultiKey(keys, counters, keystream, n);
+
+        // Walk the same blocks again to apply the keystream
+        size_t used = 0;
+        while (used < n) {
+            const BatchJob& current = jobs[job];
+            if (offset >= current.length) {
+                ++job;
+                offset = 0;
+                continue;
+            }
+            size_t bytes = current.length - offset;
+            if (bytes > (n - used) * 16) bytes = (n - used) * 16;
+            XorKeystream(current.output + offset, current.input + offset, keystream + (used * 16), bytes);
+            used += (bytes + 15) / 16;
+            offset += bytes;
+        }
+        numBlocks -= n;
+    }
+}
+
+template <int Rounds>
+void SAES<Rounds>::processBatch(const BatchJob* jobs, size_t count, ThreadPool& threadPool) {
+    const AESCore::BlockKernel<Rounds>& kernel = AESCore::ActiveKernel<Rounds>();
+
+    size_t numBlocks = 0;
+    for (size_t i = 0; i < count; ++i) {
+        numBlocks += (jobs[i].length + 15) / 16;
+    }
+    if (numBlocks == 0) return;
+
+    size_t tasks = Autotune::TaskCount(Autotune::ForKernel(kernel, threadPool), numBlocks, threadPool.concurrency());
+    if (tasks <= 1) {
+        batchXor(kernel, jobs, count, 0, 0, numBlocks);
+        return;
+    }
+
+    // Split by blocks rather than by jobs, so one long message among many short ones
+    // does not leave a single task with most of the work
+    std::vector<size_t> firstBlock(count + 1);
+    for (size_t i = 0; i < count; ++i) {
+        firstBlock[i + 1] = firstBlock[i] + (jobs[i].length + 15) / 16;
+    }
+    threadPool.parallelFor(numBlocks, (numBlocks + tasks - 1) / tasks, [&](size_t beginBlock, size_t endBlock) {
+        size_t job = static_cast<size_t>(std::upper_bound(firstBlock.begin(), firstBlock.end(), beginBlock) - firstBlock.begin()) - 1;
+        batchXor(kernel, jobs, count, job, (beginBlock - firstBlock[job]) * 16, endBlock - beginBlock);
+    });
+}
+
+template <int Rounds>
+void SAES<Rounds>::encryptBatch(const BatchJob* jobs, size_t count, ThreadPool& threadPool) {
+    processBatch(jobs, count, threadPool);
+}
+
+template <int Rounds>
+void SAES<Rounds>::decryptBatch(const BatchJob* jobs, size_t count, ThreadPool& threadPool) {
+    processBatch(jobs, count, threadPool);
+}
+
+// Absorbs length bytes into a GHASH state, zero-padding the final partial block
+static void HashPadded(const GHash::Key& hashKey, uint8_t* hashState, const uint8_t* data, size_t length) {
+    if (length == 0) return;
+    GHash::Update(hashKey, hashState, data, length / 16);
+    if (length % 16 != 0) {
+        uint8_t last[16] = {};
+        std::memcpy(last, data + (length & ~size_t(15)), length % 16);
+        GHash::Update(hashKey, hashState, last, 1);
+    }
+}
+
+template <int Rounds>
+void SAES<Rounds>::gcmXor(const uint8_t* j0, uint64_t startBlock, const uint8_t* input, uint8_t* output, size_t length,
+                          const GHash::Key& hashKey, uint8_t* hashState, bool encrypting) const {
+    uint8_t counters[CTR_BATCH * 16];
+    uint8_t keystream[CTR_BATCH * 16];
+    for (size_t b = 0; b < CTR_BATCH; ++b) {
+        std::memcpy(counters + (b * 16), j0, 12);
+    }
+    // Block i of the message uses inc32^(i + 1)(J0): only the low 32 bits count, modulo 2^32
+    uint32_t counter = static_cast<uint32_t>(LoadBE32(j0 + 12) + 1 + startBlock);
+
+    size_t offset = 0;
+    while (offset < length) {
+        size_t remaining = length - offset;
+        size_t batchBytes = remaining < sizeof(keystream) ? remaining : sizeof(keystream);
+        size_t batchBlocks = (batchBytes + 15) / 16;
+
+        for (size_t b = 0; b < batchBlocks; ++b) {
+            StoreBE32(counters + (b * 16) + 12, counter++);
+        }
+        encryptBlocks(counters, keystream, batchBlocks);
+
+        // GHASH always covers the ciphertext side; reading it before the XOR keeps
+        // in-place decryption correct
+        if (!encrypting) HashPadded(hashKey, hashState, input + offset, batchBytes);
+        XorKeystream(output + offset, input + offset, keystream, batchBytes);
+        if (encrypting) HashPadded(hashKey, hashState, output + offset, batchBytes);
+        offset += batchBytes;
+    }
+}
+
+template <int Rounds>
+void SAES<Rounds>::gcmProcess(const uint8_t* input, size_t length, const uint8_t* iv, size_t ivLength,
+                              const uint8_t* aad, size_t aadLength, uint8_t* output, uint8_t* tag, bool encrypting) {
+    if (ivLength == 0) throw std::invalid_argument("GCM requires a non-empty IV.");
+    if (uint64_t(length) > ((uint64_t(1) << 32) - 2) * 16) throw std::invalid_argument("GCM message too long.");
+
+    alignas(16) uint8_t h[16] = {};
+    encryptBlock(h, h);
+    GHash::Key hashKey;
+    GHash::Init(hashKey, h);
+
+    // Pre-counter block: IV || 0^31 || 1 for 96-bit IVs, otherwise GHASH(IV || len(IV))
+    uint8_t j0[16] = {};
+    uint8_t lengths[16] = {};
+    if (ivLength == 12) {
+        std::memcpy(j0, iv, 12);
+        j0[15] = 1;
+    } else {
+        HashPadded(hashKey, j0, iv, ivLength);
+        StoreBE64(lengths + 8, uint64_t(ivLength) * 8);
+        GHash::Update(hashKey, j0, lengths, 1);
+    }
 
-    std::vector<std::thread> threads;
-    size_t blocksPerThread = numBlocks / numThreads;
-    size_t remainder = numBlocks % numThreads;
+    uint8_t hashState[16] = {};
+    HashPadded(hashKey, hashState, aad, aadLength);
 
-    size_t currentStart = 0;
-    for (unsigned int i = 0; i < numThreads; ++i) {
-        size_t currentEnd = currentStart + blocksPerThread + (i < remainder ? 1 : 0);
-        if (currentEnd > currentStart) {
-            threads.emplace_back(processChunk, currentStart, currentEnd);
+    size_t numBlocks = (length + 15) / 16;
+    size_t tasks = length == 0 ? 1 : Autotune::TaskCount(*tuningParams, numBlocks, pool->concurrency());
+    if (tasks <= 1) {
+        gcmXor(j0, 0, input, output, length, hashKey, hashState, encrypting);
+    } else {
+        // Each range hashes its own ciphertext from zero; block i of n carries weight
+        // H^(n - i), so a range ending at block e is scaled by H^(n - e) afterwards
+        std::vector<std::array<uint8_t, 16>> partial(tasks, std::array<uint8_t, 16>{});
+        size_t base = numBlocks / tasks;
+        size_t remainder = numBlocks % tasks;
+        auto rangeStart = [&](size_t t) { return t * base + (t < remainder ? t : remainder); };
+
+        pool->runTasks(tasks, [&](size_t t) {
+            size_t startByte = rangeStart(t) * 16;
+            size_t endByte = rangeStart(t + 1) * 16 < length ? rangeStart(t + 1) * 16 : length;
+            gcmXor(j0, rangeStart(t), input + startByte, output + startByte, endByte - startByte, hashKey, partial[t].data(), encrypting);
+        });
+
+        GHash::MultiplyByPower(hashKey, hashState, numBlocks, hashState);
+        for (size_t t = 0; t < tasks; ++t) {
+            uint8_t term[16];
+            GHash::MultiplyByPower(hashKey, partial[t].data(), numBlocks - rangeStart(t + 1), term);
+            for (int i = 0; i < 16; ++i) hashState[i] ^= term[i];
         }
-        currentStart = currentEnd;
     }
 
-    for (auto& t : threads) {
-        t.join();
+    StoreBE64(lengths, uint64_t(aadLength) * 8);
+    StoreBE64(lengths + 8, uint64_t(length) * 8);
+    GHash::Update(hashKey, hashState, lengths, 1);
+
+    uint8_t mask[16];
+    encryptBlock(j0, mask);
+    for (int i = 0; i < 16; ++i) tag[i] = hashState[i] ^ mask[i];
+
+    Utils::secureZero(h, sizeof(h));
+    Utils::secureZero(&hashKey, sizeof(hashKey));
+}
+
+template <int Rounds>
+void SAES<Rounds>::encryptAuthenticated(const uint8_t* input, size_t length, const uint8_t* iv, size_t ivLength,
+                                        const uint8_t* aad, size_t aadLength, uint8_t* output, uint8_t* tag) {
+    gcmProcess(input, length, iv, ivLength, aad, aadLength, output, tag, true);
+}
+
+template <int Rounds>
+void SAES<Rounds>::decryptAuthenticated(const uint8_t* input, size_t length, const uint8_t* iv, size_t ivLength,
+                                        const uint8_t* aad, size_t aadLength, const uint8_t* tag, uint8_t* output) {
+    uint8_t computed[16];
+    gcmProcess(input, length, iv, ivLength, aad, aadLength, output, computed, false);
+
+    // Constant-time comparison; unauthenticated plaintext never reaches the caller
+    uint8_t diff = 0;
+    for (int i = 0; i < 16; ++i) diff |= static_cast<uint8_t>(computed[i] ^ tag[i]);
+    if (diff != 0) {
+        Utils::secureZero(output, length);
+        throw std::runtime_error("GCM authentication failed.");
     }
-}
\ No newline at end of file
+}
+
+template <int Rounds>
+std::vector<uint8_t> SAES<Rounds>::encryptAuthenticated(const std::vector<uint8_t>& plaintext, const std::vector<uint8_t>& iv,
+                                                        const std::vector<uint8_t>& aad) {
+    std::vector<uint8_t> sealed(plaintext.size() + TAG_SIZE);
+    encryptAuthenticated(plaintext.data(), plaintext.size(), iv.data(), iv.size(), aad.data(), aad.size(),
+                         sealed.data(), sealed.data() + plaintext.size());
+    return sealed;
+}
+
+template <int Rounds>
+std::vector<uint8_t> SAES<Rounds>::decryptAuthenticated(const std::vector<uint8_t>& sealed, const std::vector<uint8_t>& iv,
+                                                        const std::vector<uint8_t>& aad) {
+    if (sealed.size() < TAG_SIZE) throw std::invalid_argument("Sealed message is shorter than the GCM tag.");
+    size_t length = sealed.size() - TAG_SIZE;
+    std::vector<uint8_t> output(length);
+    decryptAuthenticated(sealed.data(), length, iv.data(), iv.size(), aad.data(), aad.size(),
+                         sealed.data() + length, output.data());
+    return output;
+}
+
+template <int Rounds>
+SAES<Rounds>::CtrStream::CtrStream(const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv, ThreadPool& threadPool) {
+    init(key, iv, threadPool);
+}
+
+template <int Rounds>
+void SAES<Rounds>::CtrStream::init(const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv, ThreadPool& threadPool) {
+    if (iv.size() != 16) throw std::invalid_argument("CTR stream requires a 16-byte IV.");
+    cipher.emplace(key, threadPool);
+    std::memcpy(this->iv.data(), iv.data(), 16);
+    offset = 0;
+    keystreamValid = false;
+}
+
+template <int Rounds>
+void SAES<Rounds>::CtrStream::seek(uint64_t byteOffset) {
+    offset = byteOffset;
+}
+
+template <int Rounds>
+const uint8_t* SAES<Rounds>::CtrStream::keystreamFor(uint64_t block) {
+    if (!keystreamValid || keystreamBlock != block) {
+        static const uint8_t zeros[16] = {};
+        cipher->ctrXor(iv.data(), block, zeros, keystream.data(), 16);
+        keystreamBlock = block;
+        keystreamValid = true;
+    }
+    return keystream.data();
+}
+
+template <int Rounds>
+void SAES<Rounds>::CtrStream::update(const uint8_t* input, uint8_t* output, size_t length) {
+    if (!cipher) throw std::logic_error("CTR stream used before init.");
+
+    // Finish the block a previous chunk stopped inside
+    size_t within = static_cast<size_t>(offset % 16);
+    if (within != 0 && length > 0) {
+        const uint8_t* ks = keystreamFor(offset / 16);
+        size_t n = 16 - within < length ? 16 - within : length;
+        for (size_t i = 0; i < n; ++i) output[i] = input[i] ^ ks[within + i];
+        input += n;
+        output += n;
+        length -= n;
+        offset += n;
+    }
+
+    // Whole blocks go through the batched, parallel path
+    size_t whole = length & ~size_t(15);
+    if (whole > 0) {
+        cipher->processBlocksParallel(input, whole, iv.data(), offset / 16, output);
+        input += whole;
+        output += whole;
+        length -= whole;
+        offset += whole;
+    }
+
+    // Start of a block the next chunk will finish
+    if (length > 0) {
+        const uint8_t* ks = keystreamFor(offset / 16);
+        for (size_t i = 0; i < length; ++i) output[i] = input[i] ^ ks[i];
+        offset += length;
+    }
+}
+
+template <int Rounds>
+SAES<Rounds>::KeystreamBuffer::KeystreamBuffer(const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv, size_t depthBlocks,
+                                               ThreadPool& threadPool)
+    : cipher(key, threadPool), pool(&threadPool), ring(16 * (depthBlocks > 0 ? depthBlocks : 1)), scratch(ring.size()), capacity(ring.size()) {
+    if (iv.size() != 16) throw std::invalid_argument("Keystream buffer requires a 16-byte IV.");
+    std::memcpy(this->iv.data(), iv.data(), 16);
+    refillPending = true;
+    scheduleRefill();
+}
+
+template <int Rounds>
+SAES<Rounds>::KeystreamBuffer::~KeystreamBuffer() {
+    close();
+}
+
+template <int Rounds>
+bool SAES<Rounds>::KeystreamBuffer::needsRefill() const {
+    // Refill once the ring is half drained, so one refill covers many small messages
+    return !closed && !refillPending && produced - consumed < capacity / 2;
+}
+
+// Called without the lock, after the caller has set refillPending. A pool without
+// workers has nobody to run the task in the background, so the refill runs here.
+template <int Rounds>
+void SAES<Rounds>::KeystreamBuffer::scheduleRefill() {
+    if (pool->workerCount() == 0) {
+        refill();
+        return;
+    }
+    pool->submit([this]() { refill(); });
+}
+
+template <int Rounds>
+void SAES<Rounds>::KeystreamBuffer::refill() {
+    uint64_t start;
+    size_t bytes;
+    uint64_t startGeneration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        start = produced;
+        bytes = closed ? 0 : (capacity - static_cast<size_t>(produced - consumed)) & ~size_t(15);
+        startGeneration = generation;
+    }
+
+    // Generated outside the lock into scratch, so update() never waits on the cipher
+    if (bytes > 0) {
+        std::memset(scratch.data(), 0, bytes);
+        cipher.ctrXor(iv.data(), start / 16, scratch.data(), scratch.data(), bytes);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (bytes > 0 && !closed && startGeneration == generation && produced == start) {
+        size_t pos = static_cast<size_t>(start % capacity);
+        size_t first = bytes < capacity - pos ? bytes : capacity - pos;
+        std::memcpy(ring.data() + pos, scratch.data(), first);
+        std::memcpy(ring.data(), scratch.data() + first, bytes - first);
+        produced += bytes;
+    }
+    refillPending = false;
+    workDone.notify_all();
+}
+
+template <int Rounds>
+void SAES<Rounds>::KeystreamBuffer::update(const uint8_t* input, uint8_t* output, size_t length) {
+    bool refillNow = false;
+    size_t whole = 0;
+    uint64_t wholeBlock = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed) throw std::logic_error("Keystream buffer used after close.");
+
+        // Precomputed keystream first, in up to two pieces around the end of the ring
+        size_t buffered = static_cast<size_t>(produced - consumed);
+        size_t n = length < buffered ? length : buffered;
+        size_t pos = static_cast<size_t>(consumed % capacity);
+        size_t first = n < capacity - pos ? n : capacity - pos;
+        XorKeystream(output, input, ring.data() + pos, first);
+        XorKeystream(output + first, input + first, ring.data(), n - first);
+        consumed += n;
+        input += n;
+        output += n;
+        length -= n;
+
+        // The ring ran dry at a block boundary: the rest is computed directly. An in-flight
+        // refill started from the old position, so its result is discarded. The whole
+        // blocks are only reserved here and computed below, after the lock is released:
+        // the parallel path may run this buffer's own refill task on this thread.
+        if (length > 0) {
+            ++generation;
+            whole = length & ~size_t(15);
+            wholeBlock = consumed / 16;
+            consumed += whole;
+            produced = consumed;
+            if (whole > 0) ++inlineActive;
+
+            // The partial last block goes through the ring, which keeps its unused bytes
+            size_t tail = length - whole;
+            if (tail > 0) {
+                uint8_t* block = ring.data() + (consumed % capacity);
+                std::memset(block, 0, 16);
+                cipher.ctrXor(iv.data(), consumed / 16, block, block, 16);
+                produced = consumed + 16;
+                XorKeystream(output + whole, input + whole, block, tail);
+                consumed += tail;
+            }
+        }
+
+        if (needsRefill()) {
+            refillPending = true;
+            refillNow = true;
+        }
+    }
+
+    if (whole > 0) {
+        try {
+            cipher.processBlocksParallel(input, whole, iv.data(), wholeBlock, output);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            --inlineActive;
+            if (refillNow) refillPending = false;
+            workDone.notify_all();
+            throw;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        --inlineActive;
+        workDone.notify_all();
+    }
+    if (refillNow) scheduleRefill();
+}
+
+template <int Rounds>
+uint64_t SAES<Rounds>::KeystreamBuffer::position() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return consumed;
+}
+
+template <int Rounds>
+size_t SAES<Rounds>::KeystreamBuffer::available() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<size_t>(produced - consumed);
+}
+
+template <int Rounds>
+void SAES<Rounds>::KeystreamBuffer::close() {
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this]() { return !refillPending && inlineActive == 0; });
+    if (closed) return;
+    closed = true;
+    produced = consumed;
+    Utils::secureZero(ring.data(), ring.size());
+    Utils::secureZero(scratch.data(), scratch.size());
+    Utils::secureZero(cipher.expandedKey.data(), cipher.expandedKey.size());
+    Utils::secureZero(cipher.decryptionKey.data(), cipher.decryptionKey.size());
+}
+
+template class SAES<7>;
+template class SAES<10>;
+template class SAES<12>;
+template class SAES<14>;
@@ -0,0 +1,250 @@
+#include "thread_pool.hpp"
+#include "numa.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+
+// Identifies pool workers so push/runOne use the worker's own deque
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local unsigned int currentIndex = 0;
+
+static unsigned int DefaultWorkers() {
+    unsigned int cores = std::thread::hardware_concurrency();
+    if (cores == 0) return 3;
+    return cores - 1;
+}
+
+// CPUs taken one node at a time in turn, so the first n cover every node evenly
+static std::vector<unsigned int> SpreadAcrossNodes(const Numa::Topology& topology, size_t n) {
+    std::vector<unsigned int> cpus;
+    for (size_t i = 0; cpus.size() < n; ++i) {
+        bool any = false;
+        for (const auto& nodeCpus : topology.nodeCpus) {
+            if (i < nodeCpus.size() && cpus.size() < n) {
+                cpus.push_back(nodeCpus[i]);
+                any = true;
+            }
+        }
+        if (!any) break;
+    }
+    return cpus;
+}
+
+static ThreadPool* CreateShared() {
+    const char* list = std::getenv("SAES_CPU_LIST");
+    if (list && *list) return new ThreadPool(Numa::ParseCpuList(list));
+
+    const Numa::Topology& topology = Numa::Detect();
+    if (topology.multiNode()) return new ThreadPool(SpreadAcrossNodes(topology, DefaultWorkers()));
+    return new ThreadPool(DefaultWorkers());
+}
+
+ThreadPool& ThreadPool::shared() {
+    static std::unique_ptr<ThreadPool> pool(CreateShared());
+    return *pool;
+}
+
+ThreadPool::ThreadPool(unsigned int workers) {
+    start(std::vector<int>(workers, -1));
+}
+
+ThreadPool::ThreadPool(const std::vector<unsigned int>& cpus) {
+    start(std::vector<int>(cpus.begin(), cpus.end()));
+}
+
+void ThreadPool::start(const std::vector<int>& cpus) {
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        queues.push_back(std::make_unique<Queue>());
+        int node = cpus[i] >= 0 ? Numa::NodeOfCpu(static_cast<unsigned int>(cpus[i])) : -1;
+        workerNodes.push_back(node);
+        if (node < 0) continue;
+
+        auto group = std::find_if(nodeWorkers.begin(), nodeWorkers.end(), [node](const auto& g) { return g.first == node; });
+        if (group == nodeWorkers.end()) group = nodeWorkers.insert(nodeWorkers.end(), { node, {} });
+        group->second.push_back(static_cast<unsigned int>(i));
+    }
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, static_cast<unsigned int>(i), cpus[i]);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::push(std::function<void()> task, int node) {
+    if (threads.empty()) {
+        task();
+        return;
+    }
+
+    unsigned int index = 0;
+    const std::vector<unsigned int>* placed = nullptr;
+    if (node >= 0 && nodeAware() && !(currentPool == this && workerNodes[currentIndex] == node)) {
+        for (const auto& group : nodeWorkers) {
+            if (group.first == node) placed = &group.second;
+        }
+    }
+    if (placed) {
+        index = (*placed)[nextQueue.fetch_add(1, std::memory_order_relaxed) % placed->size()];
+    } else {
+        index = currentPool == this ? currentIndex : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::runOne() {
+    size_t n = queues.size();
+    if (n == 0) return false;
+
+    std::function<void()> task;
+    size_t self = currentPool == this ? currentIndex : n;
+    if (self < n) {
+        std::lock_guard<std::mutex> lock(queues[self]->mutex);
+        if (!queues[self]->tasks.empty()) {
+            task = std::move(queues[self]->tasks.back());
+            queues[self]->tasks.pop_back();
+        }
+    }
+
+    // A pinned worker on a multi-node pool first steals from its own node, so remote
+    // memory is only touched when the local node has run dry
+    int ownNode = self < n && nodeAware() ? workerNodes[self] : -1;
+    int passes = ownNode >= 0 ? 2 : 1;
+    size_t start = self < n ? self + 1 : nextQueue.load(std::memory_order_relaxed);
+    for (int pass = 0; pass < passes && !task; ++pass) {
+        for (size_t k = 0; k < n && !task; ++k) {
+            size_t victim = (start + k) % n;
+            if (victim == self) continue;
+            if (ownNode >= 0 && (workerNodes[victim] == ownNode) != (pass == 0)) continue;
+            std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+            if (!queues[victim]->tasks.empty()) {
+                task = std::move(queues[victim]->tasks.front());
+                queues[victim]->tasks.pop_front();
+            }
+        }
+    }
+
+    if (!task) return false;
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(unsigned int index, int cpu) {
+    currentPool = this;
+    currentIndex = index;
+    if (cpu >= 0) Numa::PinCurrentThread(static_cast<unsigned int>(cpu));
+
+    while (true) {
+        if (runOne()) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping && queued.load(std::memory_order_acquire) == 0) return;
+    }
+}
+
+void ThreadPool::runTasks(size_t count, const std::function<void(size_t)>& task) {
+    runBatch(count, task, nullptr);
+}
+
+void ThreadPool::runTasks(size_t count, const std::function<void(size_t)>& task, const std::function<int(size_t)>& nodeOf) {
+    runBatch(count, task, nodeAware() ? &nodeOf : nullptr);
+}
+
+void ThreadPool::runBatch(size_t count, const std::function<void(size_t)>& task, const std::function<int(size_t)>* nodeOf) {
+    if (count == 0) return;
+    if (count == 1 || threads.empty()) {
+        for (size_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    // Shared with the queued tasks, which may still hold it briefly after the last
+    // one has signalled completion
+    struct Batch {
+        std::atomic<size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->remaining.store(count, std::memory_order_relaxed);
+
+    auto run = [batch, &task](size_t i) {
+        try {
+            task(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            if (!batch->error) batch->error = std::current_exception();
+        }
+        if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            batch->done.notify_all();
+        }
+    };
+
+    // Queue the tail and run the head here; the caller keeps executing queued tasks
+    // (its own or anyone's) rather than sleeping while work is available. With placement
+    // every task is queued on its node and the caller only helps.
+    size_t first = nodeOf ? 0 : 1;
+    for (size_t i = first; i < count; ++i) {
+        push([run, i]() { run(i); }, nodeOf ? (*nodeOf)(i) : -1);
+    }
+    if (!nodeOf) run(0);
+
+    while (batch->remaining.load(std::memory_order_acquire) != 0) {
+        if (runOne()) continue;
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->done.wait(lock, [&]() { return batch->remaining.load(std::memory_order_acquire) == 0; });
+    }
+
+    if (batch->error) std::rethrow_exception(batch->error);
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    splitRanges(count, grain, body, nullptr);
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body,
+                             const std::function<int(size_t)>& nodeOf) {
+    splitRanges(count, grain, body, nodeAware() ? &nodeOf : nullptr);
+}
+
+void ThreadPool::splitRanges(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body,
+                             const std::function<int(size_t)>* nodeOf) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    // A few ranges per thread so stealing can even out uneven progress
+    size_t tasks = (count + grain - 1) / grain;
+    size_t maxTasks = size_t(4) * concurrency();
+    if (tasks > maxTasks) tasks = maxTasks;
+    if (tasks <= 1) {
+        body(0, count);
+        return;
+    }
+
+    size_t base = count / tasks;
+    size_t remainder = count % tasks;
+    auto rangeStart = [base, remainder](size_t i) { return i * base + (i < remainder ? i : remainder); };
+    std::function<int(size_t)> rangeNode;
+    if (nodeOf) rangeNode = [&](size_t i) { return (*nodeOf)(rangeStart(i)); };
+
+    runBatch(tasks, [&](size_t i) { body(rangeStart(i), rangeStart(i + 1)); }, nodeOf ? &rangeNode : nullptr);
+}
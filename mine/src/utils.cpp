@@ -55,4 +55,11 @@ std::vector<uint8_t> fromHexString(const std::string& hex) {
     return bytes;
 }
 
+void secureZero(void* data, size_t length) {
+    volatile uint8_t* p = static_cast<volatile uint8_t*>(data);
+    for (size_t i = 0; i < length; ++i) {
+        p[i] = 0;
+    }
+}
+
 } // namespace Utils
\ No newline at end of file
@@ -0,0 +1,53 @@
+// Regression test for SAES::KeystreamBuffer::update on a one-worker pool: with the
+// worker busy, the buffer's refill task is still queued when update() falls back to
+// inline keystream, and the calling thread may pick that task up while it waits for its
+// own batch. update() must not hold the buffer's lock at that point.
+#include "s_aes.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <vector>
+
+int main() {
+    const std::vector<uint8_t> key(16, 0x2b);
+    const std::vector<uint8_t> iv(16, 0x7e);
+    std::vector<uint8_t> message(4 << 20);
+    for (size_t i = 0; i < message.size(); ++i) message[i] = static_cast<uint8_t>(i * 131);
+
+    SAES<7> reference(key);
+    std::vector<uint8_t> expected(message.size());
+    reference.encrypt(message.data(), message.size(), iv.data(), expected.data());
+
+    // Occupy the only worker, and make sure it is the worker that runs the blocker
+    ThreadPool pool(1);
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    pool.submit([&started, released]() {
+        started.set_value();
+        released.wait();
+    });
+    started.get_future().wait();
+
+    std::vector<uint8_t> output(message.size());
+    SAES<7>::KeystreamBuffer buffer(key, iv, 256, pool);
+    std::future<void> done = std::async(std::launch::async, [&]() {
+        buffer.update(message.data(), output.data(), 1000);
+        buffer.update(message.data() + 1000, output.data() + 1000, message.size() - 1000);
+    });
+    if (done.wait_for(std::chrono::seconds(60)) != std::future_status::ready) {
+        std::puts("FAIL: KeystreamBuffer::update deadlocked");
+        std::fflush(stdout);
+        std::_Exit(1);
+    }
+    done.get();
+    release.set_value();
+
+    if (output != expected) {
+        std::puts("FAIL: KeystreamBuffer output differs from SAES::encrypt");
+        return 1;
+    }
+    std::puts("PASS");
+    return 0;
+}
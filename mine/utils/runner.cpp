@@ -35,6 +35,14 @@ int main() {
     STARTUPINFOA siSender = { sizeof(STARTUPINFOA) };
     PROCESS_INFORMATION piSender;
 
+    // The receiver signals this once it is listening
+    HANDLE readyEvent = CreateEventA(NULL, TRUE, FALSE, "MRA_ReceiverReady");
+    if (!readyEvent) {
+        std::cerr << "[Runner] Failed to create ready event. Error: " << GetLastError() << std::endl;
+        return 1;
+    }
+    ResetEvent(readyEvent);
+
     std::cout << "[Runner] Starting Receiver node from " << receiverShell << std::endl;
 
     // Start Receiver
@@ -44,8 +52,15 @@ int main() {
         return 1;
     }
 
-    std::cout << "[Runner] Waiting for receiver to generate keys and listen (5 seconds)..." << std::endl;
-    Sleep(5000); // Wait for the receiver to generate its keys and start listening
+    std::cout << "[Runner] Waiting for receiver to load its key and listen..." << std::endl;
+    HANDLE waitHandles[2] = { readyEvent, piReceiver.hProcess };
+    DWORD waited = WaitForMultipleObjects(2, waitHandles, FALSE, 30000);
+    CloseHandle(readyEvent);
+    if (waited != WAIT_OBJECT_0) {
+        std::cerr << "[Runner] Receiver did not start listening." << std::endl;
+        TerminateProcess(piReceiver.hProcess, 1);
+        return 1;
+    }
 
     std::cout << "[Runner] Starting Sender node and beginning timer..." << std::endl;
 